@@ -0,0 +1,53 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstddef>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+}
+
+static std::atomic<quint64> s_count{0};
+static std::atomic<quint64> s_bytes{0};
+
+static void countAllocation(size_t size) {
+    s_count.fetch_add(1, std::memory_order_relaxed);
+    s_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// The executable's definitions take precedence over libc for every shared
+// library, so QArrayData (which calls malloc directly) is counted as well.
+// operator new goes through malloc in libstdc++.
+extern "C" void *malloc(size_t size) {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+namespace AllocationCounter {
+
+Totals current() {
+    return {s_count.load(std::memory_order_relaxed), s_bytes.load(std::memory_order_relaxed)};
+}
+
+Totals since(const Totals &start) {
+    const Totals now = current();
+    return {now.count - start.count, now.bytes - start.bytes};
+}
+
+} // namespace AllocationCounter
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QtGlobal>
+
+// Counts heap allocations made anywhere in the process, Qt containers
+// included. Linking AllocationCounter.cpp into a benchmark replaces
+// malloc/calloc/realloc with thin wrappers around glibc's allocator.
+namespace AllocationCounter {
+
+struct Totals {
+    quint64 count = 0;
+    quint64 bytes = 0;
+};
+
+Totals current();
+
+// Allocations made since `start`
+Totals since(const Totals &start);
+
+} // namespace AllocationCounter
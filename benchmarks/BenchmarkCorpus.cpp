@@ -0,0 +1,26 @@
+#include "BenchmarkCorpus.h"
+#include <QDir>
+#include <QFileInfo>
+#include <utility>
+
+namespace BenchmarkCorpus {
+
+QStringList transcripts(const QStringList &paths) {
+    QStringList roots = paths;
+    if (roots.isEmpty()) roots.append(QStringLiteral(CODEXBAR_BENCH_CORPUS));
+
+    QStringList files;
+    for (const QString &path : std::as_const(roots)) {
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            const QDir dir(path);
+            for (const QString &name : dir.entryList({"*.cxpt"}, QDir::Files, QDir::Name))
+                files.append(dir.filePath(name));
+        } else {
+            files.append(path);
+        }
+    }
+    return files;
+}
+
+} // namespace BenchmarkCorpus
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QStringList>
+
+namespace BenchmarkCorpus {
+
+// Expands directories to the .cxpt transcripts they contain; an empty list
+// means the checked-in corpus
+QStringList transcripts(const QStringList &paths);
+
+} // namespace BenchmarkCorpus
@@ -0,0 +1,167 @@
+// Parse cost per KiB of Usage-tab output, before and after the incremental
+// parser. Both sides see the same chunks: everything the transcript prints
+// after the second right arrow switched /status to the Usage tab.
+//
+//   before: the previous ClaudeProvider::parseOutput — append the chunk to
+//           the session buffer, strip ANSI from all of it and run the label
+//           regex globally, on every chunk
+//   after:  TerminalScreen::feed, ClaudeUsageParser::updateRow on the rows
+//           the chunk redrew, then isComplete()
+//
+// Usage: codexbar-parser-bench [--iterations N] [transcript.cxpt|directory ...]
+
+#include "AllocationCounter.h"
+#include "BenchmarkCorpus.h"
+#include "ClaudeUsageParser.h"
+#include "PtyTranscript.h"
+#include "TerminalScreen.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <algorithm>
+#include <cstdio>
+
+// Index of the first output chunk drawn for the Usage tab
+static qsizetype usageStageStart(const PtyTranscript &transcript) {
+    int arrows = 0;
+    for (qsizetype i = 0; i < transcript.chunks.size(); ++i) {
+        const PtyTranscript::Chunk &chunk = transcript.chunks.at(i);
+        if (chunk.direction == PtyTranscript::Direction::Input && chunk.data == "\x1b[C" && ++arrows == 2)
+            return i + 1;
+    }
+    return 0;
+}
+
+// The label regex and reset handling ClaudeProvider used before the tokenizer
+static int legacyParse(const QString &output) {
+    static QRegularExpression ansiRegex(R"(\x1B(?:[@-Z\\-_]|\[[0-?]*[ -/]*[@-~]))");
+    QString clean = output;
+    clean.remove(ansiRegex);
+
+    static QRegularExpression usageRegex(
+        R"((Current\s*session|Current\s*week\s*\(all\s*models\)|Current\s*week\s*\(Sonnet\s*only\)|Extra\s*usage)[^%]*?(\d{1,3})\s*%\s*used\s*(Rese[^\(]*\([^\)]+\))?)",
+        QRegularExpression::CaseInsensitiveOption);
+
+    int found = 0;
+    auto it = usageRegex.globalMatch(clean);
+    while (it.hasNext()) {
+        auto match = it.next();
+        QString rawReset = match.captured(3).trimmed();
+        if (!rawReset.isEmpty()) {
+            rawReset.replace(QRegularExpression(R"(\s*\([A-Za-z]+/[A-Za-z_]+\))"), "");
+            rawReset.replace(QRegularExpression(R"(^Rese\w*s\s*)", QRegularExpression::CaseInsensitiveOption), "");
+        }
+        ++found;
+    }
+    return found;
+}
+
+struct Pass {
+    qint64 ns = 0;
+    quint64 allocations = 0;
+};
+
+static Pass runBefore(const PtyTranscript &transcript, qsizetype stage) {
+    // The session buffer already holds everything printed before the stage
+    QString buffer;
+    for (qsizetype i = 0; i < stage; ++i) {
+        const PtyTranscript::Chunk &chunk = transcript.chunks.at(i);
+        if (chunk.direction == PtyTranscript::Direction::Output) buffer.append(QString::fromUtf8(chunk.data));
+    }
+
+    const AllocationCounter::Totals start = AllocationCounter::current();
+    QElapsedTimer timer;
+    timer.start();
+    for (qsizetype i = stage; i < transcript.chunks.size(); ++i) {
+        const PtyTranscript::Chunk &chunk = transcript.chunks.at(i);
+        if (chunk.direction != PtyTranscript::Direction::Output) continue;
+        buffer.append(QString::fromUtf8(chunk.data));
+        legacyParse(buffer);
+    }
+    return {timer.nsecsElapsed(), AllocationCounter::since(start).count};
+}
+
+static Pass runAfter(const PtyTranscript &transcript, qsizetype stage) {
+    TerminalScreen screen(transcript.rows, transcript.columns);
+    for (qsizetype i = 0; i < stage; ++i) {
+        const PtyTranscript::Chunk &chunk = transcript.chunks.at(i);
+        if (chunk.direction == PtyTranscript::Direction::Output) screen.feed(chunk.data);
+    }
+    screen.clearDirty();
+
+    ClaudeUsageParser parser;
+    const AllocationCounter::Totals start = AllocationCounter::current();
+    QElapsedTimer timer;
+    timer.start();
+    for (qsizetype i = stage; i < transcript.chunks.size(); ++i) {
+        const PtyTranscript::Chunk &chunk = transcript.chunks.at(i);
+        if (chunk.direction != PtyTranscript::Direction::Output) continue;
+        screen.feed(chunk.data);
+        const QList<int> rows = screen.dirtyRows();
+        for (int row : rows) {
+            parser.updateRow(row, screen.rowText(row));
+        }
+        parser.isComplete();
+        screen.clearDirty();
+    }
+    return {timer.nsecsElapsed(), AllocationCounter::since(start).count};
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser cli;
+    cli.setApplicationDescription("Claude usage panel parse cost, regex vs incremental tokenizer");
+    cli.addHelpOption();
+    QCommandLineOption iterationsOption({"n", "iterations"}, "Passes per transcript.", "count", "50");
+    cli.addOption(iterationsOption);
+    cli.addPositionalArgument("transcripts", "Transcript files or directories.", "[transcript.cxpt|directory...]");
+    cli.process(app);
+
+    const int iterations = std::max(cli.value(iterationsOption).toInt(), 1);
+    const QStringList files = BenchmarkCorpus::transcripts(cli.positionalArguments());
+    if (files.isEmpty()) {
+        std::fprintf(stderr, "No transcripts found\n");
+        return 1;
+    }
+
+    std::printf("%-32s %9s %14s %14s %16s %16s\n",
+                "transcript", "KiB", "before ns/KiB", "after ns/KiB", "before allocs/KiB", "after allocs/KiB");
+
+    for (const QString &file : files) {
+        PtyTranscript transcript;
+        if (!PtyTranscript::load(file, &transcript)) return 1;
+
+        const qsizetype stage = usageStageStart(transcript);
+        qint64 bytes = 0;
+        for (qsizetype i = stage; i < transcript.chunks.size(); ++i) {
+            if (transcript.chunks.at(i).direction == PtyTranscript::Direction::Output)
+                bytes += transcript.chunks.at(i).data.size();
+        }
+        const double kib = std::max(bytes / 1024.0, 1.0 / 1024.0);
+
+        // Warm up: compile the static regexes and fault in lazy tables
+        runBefore(transcript, stage);
+        runAfter(transcript, stage);
+
+        Pass before;
+        Pass after;
+        for (int i = 0; i < iterations; ++i) {
+            const Pass b = runBefore(transcript, stage);
+            const Pass a = runAfter(transcript, stage);
+            before.ns += b.ns;
+            before.allocations += b.allocations;
+            after.ns += a.ns;
+            after.allocations += a.allocations;
+        }
+
+        std::printf("%-32s %9.1f %14.0f %14.0f %16.1f %16.1f\n",
+                    qPrintable(QFileInfo(file).fileName()), bytes / 1024.0,
+                    before.ns / kib / iterations, after.ns / kib / iterations,
+                    before.allocations / kib / iterations, after.allocations / kib / iterations);
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Replays recorded claude sessions to measure the PTY output pipeline.
+//
+// For every transcript it reports
+//   - parse throughput: all output chunks fed through TerminalScreen, with
+//     the redrawn rows handed to ClaudeUsageParser, as ClaudeProvider does
+//   - allocations per run and per KiB of output for that pass
+//   - time-to-snapshot: ClaudeProvider replaying the transcript as fast as
+//     possible, from refresh() until it publishes its usage limits
+//
+// Usage: codexbar-replay-bench [--iterations N] [--runs N] [transcript.cxpt|directory ...]
+// Without arguments the checked-in corpus is used.
+
+#include "AllocationCounter.h"
+#include "BenchmarkCorpus.h"
+#include "ClaudeProvider.h"
+#include "ClaudeUsageParser.h"
+#include "PtyTranscript.h"
+#include "TerminalScreen.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+// Upper bound for one replay; the provider's own fallbacks are shorter
+static constexpr int kSnapshotDeadlineMs = 15000;
+
+static bool s_verbose = false;
+
+static void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &message) {
+    // Providers log every step; keep the table readable unless asked
+    if (type == QtDebugMsg && !s_verbose) return;
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+// One pass over the output the way ClaudeProvider consumes it
+static int parseTranscript(const PtyTranscript &transcript) {
+    TerminalScreen screen(transcript.rows, transcript.columns);
+    ClaudeUsageParser parser;
+    for (const PtyTranscript::Chunk &chunk : transcript.chunks) {
+        if (chunk.direction != PtyTranscript::Direction::Output) continue;
+        screen.feed(chunk.data);
+        const QList<int> rows = screen.dirtyRows();
+        for (int row : rows) {
+            parser.updateRow(row, screen.rowText(row));
+        }
+        screen.clearDirty();
+    }
+    return parser.limits().size();
+}
+
+struct SnapshotRun {
+    qint64 ms = -1; // -1: no snapshot before the replay ended
+    int limits = 0;
+};
+
+static SnapshotRun replayThroughProvider(const QString &path) {
+    qputenv("CODEXBAR_CLAUDE_REPLAY", QFile::encodeName(path));
+    qputenv("CODEXBAR_REPLAY_FAST", "1");
+
+    SnapshotRun run;
+    ClaudeProvider provider;
+    QEventLoop loop;
+    QElapsedTimer timer;
+    QObject::connect(&provider, &Provider::dataChanged, &loop, [&]() {
+        if (provider.state() != ProviderState::Active) return;
+        run.ms = timer.elapsed();
+        run.limits = provider.snapshot().limits.size();
+        loop.quit();
+    });
+    QTimer::singleShot(kSnapshotDeadlineMs, &loop, &QEventLoop::quit);
+
+    timer.start();
+    provider.refresh();
+    loop.exec();
+
+    // Let the provider finish the refresh and free its session
+    QCoreApplication::processEvents();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    return run;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(messageHandler);
+
+    QCommandLineParser cli;
+    cli.setApplicationDescription("Replay benchmark for the Claude PTY pipeline");
+    cli.addHelpOption();
+    QCommandLineOption iterationsOption({"n", "iterations"}, "Parse passes per transcript.", "count", "50");
+    QCommandLineOption runsOption({"r", "runs"}, "Provider replays per transcript.", "count", "5");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Show debug output.");
+    cli.addOption(iterationsOption);
+    cli.addOption(runsOption);
+    cli.addOption(verboseOption);
+    cli.addPositionalArgument("transcripts", "Transcript files or directories.", "[transcript.cxpt|directory...]");
+    cli.process(app);
+
+    s_verbose = cli.isSet(verboseOption);
+    const int iterations = std::max(cli.value(iterationsOption).toInt(), 1);
+    const int runs = std::max(cli.value(runsOption).toInt(), 1);
+    const QStringList files = BenchmarkCorpus::transcripts(cli.positionalArguments());
+    if (files.isEmpty()) {
+        std::fprintf(stderr, "No transcripts found\n");
+        return 1;
+    }
+
+    std::printf("%-32s %9s %7s %8s %11s %9s %10s %12s %6s\n",
+                "transcript", "size", "bytes", "chunks", "parse MiB/s", "allocs", "allocs/KiB",
+                "snapshot ms", "limits");
+
+    bool failed = false;
+    for (const QString &file : files) {
+        PtyTranscript transcript;
+        if (!PtyTranscript::load(file, &transcript)) {
+            failed = true;
+            continue;
+        }
+
+        qint64 outputBytes = 0;
+        int outputChunks = 0;
+        for (const PtyTranscript::Chunk &chunk : std::as_const(transcript.chunks)) {
+            if (chunk.direction != PtyTranscript::Direction::Output) continue;
+            outputBytes += chunk.data.size();
+            ++outputChunks;
+        }
+
+        // Warm up once so lazily built tables don't count against the first run
+        parseTranscript(transcript);
+
+        const AllocationCounter::Totals allocStart = AllocationCounter::current();
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        for (int i = 0; i < iterations; ++i) {
+            parseTranscript(transcript);
+        }
+        const qint64 parseNs = std::max<qint64>(parseTimer.nsecsElapsed(), 1);
+        const AllocationCounter::Totals allocs = AllocationCounter::since(allocStart);
+
+        const double mibPerSecond = double(outputBytes) * iterations / (1024.0 * 1024.0) / (parseNs / 1e9);
+        const double allocsPerRun = double(allocs.count) / iterations;
+        const double allocsPerKiB = allocsPerRun / std::max(outputBytes / 1024.0, 1.0);
+
+        QList<qint64> snapshotMs;
+        int limits = 0;
+        for (int i = 0; i < runs; ++i) {
+            const SnapshotRun run = replayThroughProvider(file);
+            if (run.ms < 0) break;
+            snapshotMs.append(run.ms);
+            limits = run.limits;
+        }
+
+        QString snapshot = "none";
+        if (snapshotMs.size() == runs) {
+            std::sort(snapshotMs.begin(), snapshotMs.end());
+            snapshot = QString::number(snapshotMs.at(snapshotMs.size() / 2));
+        } else {
+            failed = true;
+        }
+
+        std::printf("%-32s %4dx%-4d %7lld %8d %11.1f %9.0f %10.1f %12s %6d\n",
+                    qPrintable(QFileInfo(file).fileName()), transcript.columns, transcript.rows,
+                    static_cast<long long>(outputBytes), outputChunks, mibPerSecond, allocsPerRun, allocsPerKiB,
+                    qPrintable(snapshot), limits);
+    }
+
+    // Non-zero when a transcript could not be loaded or never produced a snapshot
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+// Spawn latency of a PTY child: fork()+exec, as PtySession used to launch
+// claude, against the posix_spawn path it uses now, and PtySession::start
+// end to end. The parent carries a touched heap ballast so fork() has the
+// page tables of a running Qt/KF6 process to copy.
+//
+// Usage: codexbar-spawn-bench [--iterations N] [--heap-mib N] [program]
+
+#include "AllocationCounter.h"
+#include "PtySession.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QList>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <pty.h>
+#include <spawn.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+struct Sample {
+    qint64 spawnNs = 0; // Until fork()/posix_spawn returned in the parent
+    qint64 totalNs = 0; // Until the child was reaped
+};
+
+static bool openTerminal(int *masterFd, int *slaveFd, char *slaveName) {
+    struct winsize ws = {};
+    ws.ws_row = 40;
+    ws.ws_col = 120;
+    if (openpty(masterFd, slaveFd, slaveName, nullptr, &ws) == -1) return false;
+    fcntl(*masterFd, F_SETFD, FD_CLOEXEC);
+    fcntl(*slaveFd, F_SETFD, FD_CLOEXEC);
+    return true;
+}
+
+// The previous PtySession::start: fork, then set up the TTY and exec in the child
+static bool forkExec(const char *program, Sample *sample) {
+    int masterFd, slaveFd;
+    char slaveName[1024];
+    if (!openTerminal(&masterFd, &slaveFd, slaveName)) return false;
+
+    QElapsedTimer timer;
+    timer.start();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        setsid();
+        ioctl(slaveFd, TIOCSCTTY, nullptr);
+        dup2(slaveFd, STDIN_FILENO);
+        dup2(slaveFd, STDOUT_FILENO);
+        dup2(slaveFd, STDERR_FILENO);
+        setenv("TERM", "xterm-256color", 0);
+        char *args[] = {const_cast<char *>(program), nullptr};
+        execvp(program, args);
+        _exit(127);
+    }
+    sample->spawnNs = timer.nsecsElapsed();
+
+    ::close(slaveFd);
+    if (pid > 0) waitpid(pid, nullptr, 0);
+    sample->totalNs = timer.nsecsElapsed();
+    ::close(masterFd);
+    return pid > 0;
+}
+
+// Same attributes and file actions as PtySession::start
+static bool posixSpawn(const char *program, Sample *sample) {
+    int masterFd, slaveFd;
+    char slaveName[1024];
+    if (!openTerminal(&masterFd, &slaveFd, slaveName)) return false;
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, slaveName, O_RDWR, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO);
+
+    char *args[] = {const_cast<char *>(program), nullptr};
+    QElapsedTimer timer;
+    timer.start();
+    pid_t pid = -1;
+    const int error = posix_spawn(&pid, program, &actions, &attr, args, environ);
+    sample->spawnNs = timer.nsecsElapsed();
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    ::close(slaveFd);
+    if (error == 0) waitpid(pid, nullptr, 0);
+    sample->totalNs = timer.nsecsElapsed();
+    ::close(masterFd);
+    return error == 0;
+}
+
+// PtySession::start through to processExited, including the event loop
+static bool ptySession(const char *program, Sample *sample) {
+    PtySession session;
+    QEventLoop loop;
+    QObject::connect(&session, &PtySession::processExited, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!session.start(QString::fromLocal8Bit(program), {})) return false;
+    sample->spawnNs = timer.nsecsElapsed();
+    loop.exec();
+    sample->totalNs = timer.nsecsElapsed();
+    return true;
+}
+
+static qint64 percentileUs(QList<qint64> values, double p) {
+    if (values.isEmpty()) return 0;
+    std::sort(values.begin(), values.end());
+    const qsizetype index = std::min(static_cast<qsizetype>(values.size() * p / 100.0), values.size() - 1);
+    return values.at(index) / 1000;
+}
+
+static void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &message) {
+    if (type == QtDebugMsg) return;
+    std::fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(messageHandler);
+
+    QCommandLineParser cli;
+    cli.setApplicationDescription("Spawn latency of PTY children: fork+exec vs posix_spawn");
+    cli.addHelpOption();
+    QCommandLineOption iterationsOption({"n", "iterations"}, "Spawns per method.", "count", "200");
+    QCommandLineOption heapOption("heap-mib", "Touched heap ballast in the parent.", "MiB", "256");
+    cli.addOption(iterationsOption);
+    cli.addOption(heapOption);
+    cli.addPositionalArgument("program", "Absolute path of the child to run.", "[program]");
+    cli.process(app);
+
+    const int iterations = std::max(cli.value(iterationsOption).toInt(), 1);
+    const qsizetype heapBytes = qsizetype(std::max(cli.value(heapOption).toInt(), 0)) * 1024 * 1024;
+    const QByteArray program = cli.positionalArguments().value(0, "/bin/true").toLocal8Bit();
+
+    // Resident, written pages: fork() has to copy their page tables
+    std::vector<char> ballast(heapBytes);
+    std::memset(ballast.data(), 1, ballast.size());
+
+    struct Method {
+        const char *name;
+        bool (*run)(const char *, Sample *);
+    };
+    const Method methods[] = {
+        {"fork+exec", forkExec},
+        {"posix_spawn", posixSpawn},
+        {"PtySession::start", ptySession},
+    };
+
+    std::printf("%s, %d spawns each, %lld MiB heap\n", program.constData(), iterations,
+                static_cast<long long>(heapBytes / (1024 * 1024)));
+    std::printf("%-18s %12s %12s %12s %12s %10s\n",
+                "method", "spawn p50", "spawn p90", "exit p50", "exit p90", "allocs");
+
+    for (const Method &method : methods) {
+        QList<qint64> spawnNs;
+        QList<qint64> totalNs;
+        const AllocationCounter::Totals allocStart = AllocationCounter::current();
+        for (int i = 0; i < iterations; ++i) {
+            Sample sample;
+            if (!method.run(program.constData(), &sample)) {
+                std::fprintf(stderr, "%s failed to start %s\n", method.name, program.constData());
+                return 1;
+            }
+            spawnNs.append(sample.spawnNs);
+            totalNs.append(sample.totalNs);
+        }
+        const AllocationCounter::Totals allocs = AllocationCounter::since(allocStart);
+
+        std::printf("%-18s %10lldus %10lldus %10lldus %10lldus %10.1f\n", method.name,
+                    percentileUs(spawnNs, 50), percentileUs(spawnNs, 90),
+                    percentileUs(totalNs, 50), percentileUs(totalNs, 90),
+                    double(allocs.count) / iterations);
+    }
+    return 0;
+}
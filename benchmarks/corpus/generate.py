@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""Regenerate the replay corpus used by codexbar-replay-bench.
+
+The transcripts reproduce what `claude` draws through Ink: frames that erase
+and redraw the previous one, SGR colours, box borders, the first-run theme
+and trust dialogs, the /status tabs and the Usage panel. Output is cut into
+chunks at arbitrary byte offsets (mid escape sequence, mid UTF-8) the way
+PTY reads split it. Sessions recorded with CODEXBAR_PTY_RECORD can be
+dropped next to these files and are picked up by the benchmark as well.
+"""
+
+import os
+import random
+import struct
+
+MAGIC = 0x43585054  # "CXPT"
+VERSION = 1
+OUTPUT, INPUT = 0, 1
+
+DIM = "\x1b[2m"
+BOLD = "\x1b[1m"
+ACCENT = "\x1b[38;2;215;119;87m"
+RESET = "\x1b[0m"
+
+
+class Transcript:
+    def __init__(self, rows, columns, seed):
+        self.rows = rows
+        self.columns = columns
+        self.rng = random.Random(seed)
+        self.chunks = []
+        self.clock_us = 0
+        self.last_us = 0
+        self.frame_height = 0
+
+    def wait(self, ms):
+        self.clock_us += int(ms * 1000)
+
+    def output(self, text):
+        data = text.encode("utf-8")
+        pos = 0
+        while pos < len(data):
+            size = self.rng.randint(64, 4096)
+            self.chunks.append((OUTPUT, self.clock_us, data[pos:pos + size]))
+            pos += size
+            self.clock_us += self.rng.randint(50, 400)
+
+    def input(self, text):
+        self.chunks.append((INPUT, self.clock_us, text.encode("utf-8")))
+
+    def frame(self, lines):
+        # Ink's log-update: erase the previous frame line by line, then draw
+        erase = ""
+        for i in range(self.frame_height):
+            erase += "\x1b[2K" + ("\x1b[1A" if i < self.frame_height - 1 else "")
+        if self.frame_height:
+            erase += "\x1b[G"
+        self.output(erase + "\n".join(lines) + "\n")
+        self.frame_height = len(lines) + 1
+
+    def write(self, path):
+        with open(path, "wb") as f:
+            f.write(struct.pack(">IHHH", MAGIC, VERSION, self.rows, self.columns))
+            for direction, offset_us, data in self.chunks:
+                delta = offset_us - self.last_us
+                self.last_us = offset_us
+                f.write(struct.pack(">BII", direction, delta, len(data)))
+                f.write(data)
+
+
+def box(width, body):
+    inner = width - 2
+    lines = [ACCENT + "╭" + "─" * inner + "╮" + RESET]
+    for text in body:
+        visible = strip(text)
+        lines.append(ACCENT + "│" + RESET + text + " " * max(inner - len(visible), 0) + ACCENT + "│" + RESET)
+    lines.append(ACCENT + "╰" + "─" * inner + "╯" + RESET)
+    return lines
+
+
+def strip(text):
+    out, i = "", 0
+    while i < len(text):
+        if text[i] == "\x1b":
+            i += 2
+            while i < len(text) and not ("@" <= text[i] <= "~"):
+                i += 1
+            i += 1
+            continue
+        out += text[i]
+        i += 1
+    return out
+
+
+def welcome(columns):
+    width = min(columns - 2, 58)
+    return box(width, [
+        " " + ACCENT + "✻" + RESET + " Welcome to " + BOLD + "Claude Code" + RESET + "!",
+        "",
+        "   " + DIM + "/help for help, /status for your current setup" + RESET,
+        "",
+        "   " + DIM + "cwd: /home/user/projects/kdecodexbar" + RESET,
+    ])
+
+
+def prompt(columns, typed=""):
+    return box(columns - 2, [" > " + typed]) + ["  " + DIM + "? for shortcuts" + RESET]
+
+
+def theme_dialog(columns, selected):
+    options = ["Dark mode", "Light mode", "Dark mode (colorblind-friendly)", "Light mode (colorblind-friendly)"]
+    body = [" " + BOLD + "Let's get started." + RESET, "",
+            " Choose the text style that looks best with your terminal:", ""]
+    for i, option in enumerate(options):
+        marker = ACCENT + "❯ " + RESET if i == selected else "  "
+        body.append(" " + marker + "%d. %s" % (i + 1, option) + (" ✔" if i == 0 else ""))
+    return box(columns - 2, body)
+
+
+def trust_dialog(columns):
+    return box(columns - 2, [
+        " " + BOLD + "Do you trust the files in this folder?" + RESET,
+        "",
+        " /home/user/projects/kdecodexbar",
+        "",
+        " Claude Code may read files in this folder. Reading untrusted files may lead",
+        " Claude Code to behave in unexpected ways.",
+        "",
+        " " + ACCENT + "❯ " + RESET + "1. Yes, I trust this folder",
+        "   2. No, exit",
+    ])
+
+
+def tabs(active):
+    names = ["Status", "Config", "Usage"]
+    return "  " + "   ".join((BOLD + ACCENT + n + RESET) if n == active else (DIM + n + RESET) for n in names)
+
+
+def status_tab(columns):
+    return box(columns - 2, [
+        tabs("Status"), "",
+        " Version: 2.0.14",
+        " Session ID: 6f0c1b9e-3d2a-4f5e-9a8b-7c6d5e4f3a2b",
+        " cwd: /home/user/projects/kdecodexbar",
+        " Login method: Claude Max Account",
+        " Organization: user@example.com's Organization",
+        " Model: Default (claude-sonnet)",
+    ])
+
+
+def config_tab(columns):
+    return box(columns - 2, [
+        tabs("Config"), "",
+        " " + ACCENT + "❯ " + RESET + "Auto-compact                    true",
+        "   Show tips                       true",
+        "   Rewind code (checkpoints)       true",
+        "   Verbose output                  false",
+        "   Theme                           Dark mode",
+        "   Notifications                   Auto",
+        "   Output style                    default",
+    ])
+
+
+def usage_tab(columns, percents, sonnet=True):
+    bar = columns - 24
+
+    def meter(percent):
+        filled = bar * percent // 100
+        return " " + ACCENT + "█" * filled + RESET + DIM + "░" * (bar - filled) + RESET + "  %d%% used" % percent
+
+    body = [tabs("Usage"), "",
+            " " + BOLD + "Current session" + RESET, meter(percents[0]),
+            " " + DIM + "Resets 11:59pm (Europe/Bucharest)" + RESET, "",
+            " " + BOLD + "Current week (all models)" + RESET, meter(percents[1]),
+            " " + DIM + "Resets Dec 30, 9:59am (Europe/Bucharest)" + RESET, ""]
+    if sonnet:
+        body += [" " + BOLD + "Current week (Sonnet only)" + RESET, meter(percents[2]),
+                 " " + DIM + "Resets Dec 30, 9:59am (Europe/Bucharest)" + RESET, ""]
+    body += [" " + BOLD + "Extra usage" + RESET,
+             " " + DIM + "Extra usage not enabled • /extra-usage to enable" + RESET, "",
+             " " + DIM + "Esc to cancel" + RESET]
+    return box(columns - 2, body)
+
+
+def session(path, rows, columns, seed, first_run=False, sonnet=True):
+    t = Transcript(rows, columns, seed)
+    t.output("\x1b[?25l\x1b[?2004h")
+    t.wait(180)
+
+    if first_run:
+        for selected in (0, 0, 0):
+            t.frame(theme_dialog(columns, selected))
+            t.wait(120)
+        t.wait(400)
+        t.input("\r")
+        t.wait(60)
+        t.frame(trust_dialog(columns))
+        t.wait(300)
+        t.input("\r")
+        t.wait(80)
+
+    # Welcome banner and a few redraws while the CLI finishes starting
+    for _ in range(4):
+        t.frame(welcome(columns) + [""] + prompt(columns))
+        t.wait(90)
+    t.wait(250)
+
+    t.input("/status\r")
+    for typed in ("/", "/s", "/status"):
+        t.frame(welcome(columns) + [""] + prompt(columns, typed))
+        t.wait(15)
+    t.wait(120)
+
+    for _ in range(2):
+        t.frame(welcome(columns) + [""] + status_tab(columns))
+        t.wait(40)
+    t.input("\x1b[C")
+    t.wait(30)
+    t.frame(welcome(columns) + [""] + config_tab(columns))
+    t.wait(50)
+    t.input("\x1b[C")
+    t.wait(30)
+
+    # The usage panel first renders a loading line, then the limits
+    t.frame(welcome(columns) + [""] + box(columns - 2, [tabs("Usage"), "", " " + DIM + "Loading usage data…" + RESET]))
+    t.wait(650)
+    percents = [t.rng.randint(1, 99) for _ in range(3)]
+    for _ in range(3):
+        t.frame(welcome(columns) + [""] + usage_tab(columns, percents, sonnet))
+        t.wait(100)
+
+    t.write(path)
+
+
+if __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(__file__))
+    session(os.path.join(here, "claude-status-120x40.cxpt"), 40, 120, 1)
+    session(os.path.join(here, "claude-first-run-120x40.cxpt"), 40, 120, 2, first_run=True)
+    session(os.path.join(here, "claude-status-80x24.cxpt"), 24, 80, 3, sonnet=False)
+    session(os.path.join(here, "claude-first-run-80x24.cxpt"), 24, 80, 4, first_run=True)
+    session(os.path.join(here, "claude-status-200x50.cxpt"), 50, 200, 5)
@@ -15,7 +15,7 @@ SettingsDialog::SettingsDialog(QWidget *parent)
     , m_settings("KDECodexBar", "KDECodexBar")
 {
     setWindowTitle(tr("Settings"));
-    setFixedSize(300, 200);
+    setFixedSize(300, 340);
 
     QVBoxLayout *layout = new QVBoxLayout(this);
 
@@ -31,12 +31,35 @@ SettingsDialog::SettingsDialog(QWidget *parent)
     m_intervalCombo->addItem(tr("15 Minutes"), 900000);
     layout->addWidget(m_intervalCombo);
 
+    // Providers whose usage stays flat back off toward this interval
+    QLabel *maxIntervalLabel = new QLabel(tr("Slowest Refresh When Idle:"), this);
+    layout->addWidget(maxIntervalLabel);
+
+    m_maxIntervalCombo = new QComboBox(this);
+    m_maxIntervalCombo->addItem(tr("5 Minutes"), 300000);
+    m_maxIntervalCombo->addItem(tr("15 Minutes"), 900000);
+    m_maxIntervalCombo->addItem(tr("30 Minutes"), 1800000);
+    m_maxIntervalCombo->addItem(tr("1 Hour"), 3600000);
+    layout->addWidget(m_maxIntervalCombo);
+
     layout->addSpacing(10);
 
     // Autostart
     m_autostartCheck = new QCheckBox(tr("Run at Startup"), this);
     layout->addWidget(m_autostartCheck);
 
+    // Keep claude running between refreshes instead of respawning it
+    m_claudeKeepSessionCheck = new QCheckBox(tr("Keep Claude session running"), this);
+    layout->addWidget(m_claudeKeepSessionCheck);
+
+    // Keep codex app-server running and listen for pushed rate-limit updates
+    m_codexKeepServerCheck = new QCheckBox(tr("Keep Codex app-server running"), this);
+    layout->addWidget(m_codexKeepServerCheck);
+
+    // Store TLS session tickets on disk so the first refresh after login resumes
+    m_tlsSessionCacheCheck = new QCheckBox(tr("Remember TLS sessions across restarts"), this);
+    layout->addWidget(m_tlsSessionCacheCheck);
+
     layout->addStretch();
 
     // Buttons
@@ -52,10 +75,26 @@ int SettingsDialog::refreshInterval() const {
     return m_intervalCombo->currentData().toInt();
 }
 
+int SettingsDialog::maxRefreshInterval() const {
+    return m_maxIntervalCombo->currentData().toInt();
+}
+
 bool SettingsDialog::isAutostartEnabled() const {
     return m_autostartCheck->isChecked();
 }
 
+bool SettingsDialog::isClaudeKeepSessionEnabled() const {
+    return m_claudeKeepSessionCheck->isChecked();
+}
+
+bool SettingsDialog::isCodexKeepServerEnabled() const {
+    return m_codexKeepServerCheck->isChecked();
+}
+
+bool SettingsDialog::isTlsSessionCacheEnabled() const {
+    return m_tlsSessionCacheCheck->isChecked();
+}
+
 void SettingsDialog::loadSettings() {
     int interval = m_settings.value("refresh_interval", 60000).toInt(); // Default 1 min
     int index = m_intervalCombo->findData(interval);
@@ -65,13 +104,24 @@ void SettingsDialog::loadSettings() {
         m_intervalCombo->setCurrentIndex(1); // Default to 1 min if unknown
     }
 
+    index = m_maxIntervalCombo->findData(m_settings.value("refresh_interval_max", 900000).toInt());
+    m_maxIntervalCombo->setCurrentIndex(index != -1 ? index : 1); // Default 15 min
+
     bool autostart = m_settings.value("autostart", false).toBool();
     m_autostartCheck->setChecked(autostart);
+
+    m_claudeKeepSessionCheck->setChecked(m_settings.value("claude_keep_session", false).toBool());
+    m_codexKeepServerCheck->setChecked(m_settings.value("codex_keep_server", false).toBool());
+    m_tlsSessionCacheCheck->setChecked(m_settings.value("tls_session_cache", false).toBool());
 }
 
 void SettingsDialog::saveSettings() {
     m_settings.setValue("refresh_interval", refreshInterval());
+    m_settings.setValue("refresh_interval_max", maxRefreshInterval());
     m_settings.setValue("autostart", isAutostartEnabled());
+    m_settings.setValue("claude_keep_session", isClaudeKeepSessionEnabled());
+    m_settings.setValue("codex_keep_server", isCodexKeepServerEnabled());
+    m_settings.setValue("tls_session_cache", isTlsSessionCacheEnabled());
     
     updateAutostart(isAutostartEnabled());
     
@@ -14,7 +14,11 @@ public:
 
     // Getters for current settings
     int refreshInterval() const; // in ms, -1 for manual
+    int maxRefreshInterval() const; // in ms, while usage is not moving
     bool isAutostartEnabled() const;
+    bool isClaudeKeepSessionEnabled() const;
+    bool isCodexKeepServerEnabled() const;
+    bool isTlsSessionCacheEnabled() const;
 
 signals:
     void settingsChanged();
@@ -26,7 +30,11 @@ private slots:
 
 private:
     QComboBox *m_intervalCombo;
+    QComboBox *m_maxIntervalCombo;
     QCheckBox *m_autostartCheck;
+    QCheckBox *m_claudeKeepSessionCheck;
+    QCheckBox *m_codexKeepServerCheck;
+    QCheckBox *m_tlsSessionCacheCheck;
     QDialogButtonBox *m_buttonBox;
     QSettings m_settings;
 };
@@ -16,7 +16,7 @@ TrayIcon::TrayIcon(ProviderRegistry *registry, QObject *parent)
     , m_sni(new KStatusNotifierItem(this))
     , m_menu(new QMenu())
     , m_registry(registry)
-    , m_timer(new QTimer(this))
+    , m_scheduler(new RefreshScheduler(this))
     , m_selectedProviderID(static_cast<ProviderID>(QSettings("KDECodexBar", "KDECodexBar").value("selected_provider", static_cast<int>(ProviderID::Codex)).toInt()))
 {
     // Basic SNI setup
@@ -36,31 +36,20 @@ TrayIcon::TrayIcon(ProviderRegistry *registry, QObject *parent)
     setupMenu();
     m_sni->setContextMenu(m_menu);
     
-    // Connect providers
+    // Connect providers; each one is refreshed on its own schedule
     for (auto *provider : m_registry->providers()) {
         connect(provider, &Provider::dataChanged, this, &TrayIcon::updateIcon);
+        m_scheduler->addProvider(provider);
     }
-    
-    // Setup refresh timer (every 60s)
-    connect(m_timer, &QTimer::timeout, this, [this](){
-        for (auto *provider : m_registry->providers()) {
-            provider->refresh();
-        }
-    });
-    m_timer->start(60000); 
+    m_scheduler->setPreferredProvider(m_selectedProviderID);
     
     // Initial refresh
     QTimer::singleShot(0, this, [this](){
-        // Create settings dialog to load initial settings (or just use QSettings directly here)
-        // Since we want to respect the saved interval, we should read it properly.
+        // Respect the saved bounds before the first round is scheduled
         QSettings s("KDECodexBar", "KDECodexBar");
-        int interval = s.value("refresh_interval", 60000).toInt();
-        if (interval > 0) m_timer->start(interval);
-        else m_timer->stop();
-
-        for (auto *provider : m_registry->providers()) {
-            provider->refresh();
-        }
+        m_scheduler->setIntervals(s.value("refresh_interval", 60000).toInt(),
+                                  s.value("refresh_interval_max", 900000).toInt());
+        m_scheduler->refreshAll();
     });
 }
 
@@ -138,6 +127,7 @@ void TrayIcon::setupMenu() {
         connect(header, &QAction::triggered, this, [this, provider](){
             m_selectedProviderID = provider->id();
             QSettings("KDECodexBar", "KDECodexBar").setValue("selected_provider", static_cast<int>(m_selectedProviderID));
+            m_scheduler->setPreferredProvider(m_selectedProviderID);
             updateIcon(); // Will redraw icon/tooltip and rebuild menu (updating checks)
         });
 
@@ -178,9 +168,7 @@ void TrayIcon::setupMenu() {
     });
     
     m_menu->addAction(i18n("Refresh All"), this, [this](){
-        for (auto *provider : m_registry->providers()) {
-            provider->refresh();
-        }
+        m_scheduler->refreshAll();
     });
     
     m_menu->addSeparator();
@@ -193,10 +181,5 @@ void TrayIcon::setupMenu() {
 void TrayIcon::applySettings() {
     if (!m_settingsDialog) return;
     
-    int interval = m_settingsDialog->refreshInterval();
-    if (interval > 0) {
-        m_timer->start(interval);
-    } else {
-        m_timer->stop();
-    }
+    m_scheduler->setIntervals(m_settingsDialog->refreshInterval(), m_settingsDialog->maxRefreshInterval());
 }
@@ -6,6 +6,7 @@
 #include <QObject>
 #include <QTimer>
 #include "ProviderRegistry.h"
+#include "RefreshScheduler.h"
 #include "MenuWidget.h"
 #include "SettingsDialog.h"
 
@@ -32,7 +33,7 @@ private:
     QAction *m_claudeSessionAction;
     QAction *m_claudeWeeklyAction;
     ProviderRegistry *m_registry;
-    QTimer *m_timer;
+    RefreshScheduler *m_scheduler;
     ProviderID m_selectedProviderID;
     SettingsDialog *m_settingsDialog = nullptr;
     
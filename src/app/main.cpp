@@ -2,6 +2,7 @@
 #include <KLocalizedString>
 #include <QApplication>
 
+#include "BinaryLocator.h"
 #include "ProviderRegistry.h"
 #include "TrayIcon.h"
 
@@ -19,6 +20,9 @@ int main(int argc, char *argv[]) {
   app.setDesktopFileName("kdecodexbar");
   app.setQuitOnLastWindowClosed(false);
 
+  // Resolve tools against the same PATH a terminal would use
+  BinaryLocator::instance()->captureLoginShellPath();
+
   auto *registry = new ProviderRegistry(&app);
   auto *trayIcon = new TrayIcon(registry, &app);
   // TODO: Connect registry to trayIcon
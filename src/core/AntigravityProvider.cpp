@@ -1,213 +1,390 @@
 #include "AntigravityProvider.h"
+#include "ProcessScanner.h"
+#include "ProcessWatcher.h"
 #include <QDebug>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QRegularExpression>
 #include <QDateTime>
-#include <QNetworkReply>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
 #include <QSslConfiguration>
-#include <QStandardPaths>
+#include <algorithm>
+#include <utility>
 
-static const QString kProcessName = "language_server_linux_x64"; // From user's ps aux
+static const QString kProcessName = "language_server_linux_x64"; // comm is "language_server"
 static const QString kUserStatusPath = "/exa.language_server_pb.LanguageServerService/GetUserStatus";
 static const QString kCommandModelPath = "/exa.language_server_pb.LanguageServerService/GetCommandModelConfigs";
-static const QString kUnleashPath = "/exa.language_server_pb.LanguageServerService/GetUnleashData";
+
+// The language server is local; anything slower than this is stuck
+static constexpr int kRequestTimeoutMs = 5000;
+// Probes only need to tell the API port from the others
+static constexpr int kProbeTimeoutMs = 1500;
+// A freshly exec'd server needs a moment to open its ports
+static constexpr int kDiscoveryDelayMs = 1000;
+// Model configs are re-fetched after this long
+static constexpr qint64 kModelConfigTtlMs = 30 * 60 * 1000;
+// While hibernating with exec events, every Nth refresh still scans, so a
+// single missed event can't keep the provider asleep
+static constexpr int kHibernatingScanInterval = 10;
 
 AntigravityProvider::AntigravityProvider(QObject *parent)
     : Provider(ProviderID::Antigravity, parent)
-    , m_nam(new QNetworkAccessManager(this))
     , m_isFetching(false)
+    , m_watcher(new ProcessWatcher(kProcessName, this))
 {
+    m_discoveryDebounce.setSingleShot(true);
+    // A running refresh is waited for by the scheduler
+    connect(&m_discoveryDebounce, &QTimer::timeout, this, &AntigravityProvider::refreshRequested);
+
+    connect(m_watcher, &ProcessWatcher::processStarted, this, &AntigravityProvider::onServerStarted);
+    connect(m_watcher, &ProcessWatcher::rescanNeeded, this, &AntigravityProvider::onRescanNeeded);
+    connect(m_watcher, &ProcessWatcher::processExited, this, &AntigravityProvider::onServerExited);
 }
 
 AntigravityProvider::~AntigravityProvider() = default;
 
+// Every IDE window runs its own language server. All of them are queried
+// at once, so a refresh takes as long as the slowest single instance.
 void AntigravityProvider::refresh() {
-    if (m_isFetching) return;
+    if (m_isFetching) {
+        emit refreshSkipped();
+        return;
+    }
+
+    // Exec events wake us up; without them a poll is the only way to notice
+    if (m_hibernating && m_watcher->usesProcConnector() && ++m_skippedScans < kHibernatingScanInterval) {
+        emit refreshSkipped();
+        return;
+    }
+    m_skippedScans = 0;
+
+    const QList<ProcessInfo> processes = detectProcesses();
+
+    m_livePids.clear();
+    QStringList dataDirs;
+    for (const ProcessInfo &info : processes) {
+        m_livePids.insert(info.pid);
+        m_watcher->watchPid(info.pid);
+        dataDirs.append(info.appDataDir);
+    }
+    // Directories of exited servers are dropped; after the last one exits
+    // its directory stays watched, to notice the IDE coming back
+    if (!processes.isEmpty()) m_watcher->setWatchedDirectories(dataDirs);
+
+    // Forget endpoints and configs of servers that went away (or whose PID was recycled)
+    QHash<int, quint64> startTimes;
+    for (const ProcessInfo &info : processes) {
+        startTimes.insert(info.pid, info.startTime);
+    }
+    auto alive = [&startTimes](int pid, quint64 startTime) {
+        auto it = startTimes.constFind(pid);
+        return it != startTimes.cend() && *it == startTime;
+    };
+    for (auto it = m_endpoints.begin(); it != m_endpoints.end();) {
+        it = alive(it.key(), it->startTime) ? std::next(it) : m_endpoints.erase(it);
+    }
+    for (auto it = m_modelConfigs.begin(); it != m_modelConfigs.end();) {
+        it = alive(it.key(), it->startTime) ? std::next(it) : m_modelConfigs.erase(it);
+    }
+
+    if (processes.isEmpty()) {
+        qDebug() << "AntigravityProvider: Process not found";
+        setState(ProviderState::Error); 
+        m_hibernating = true;
+        emit refreshSkipped();
+        return;
+    }
+    m_hibernating = false;
+
     m_isFetching = true;
-    detectProcess();
+    ++m_round;
+    m_instances.clear();
+    for (const ProcessInfo &info : processes) {
+        m_instances.insert(info.pid, {info});
+    }
+    for (const ProcessInfo &info : processes) {
+        fetchInstance(info.pid);
+    }
 }
 
-void AntigravityProvider::detectProcess() {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus status) {
-        process->deleteLater();
-        if (status != QProcess::NormalExit || exitCode != 0) {
-            setState(ProviderState::Error);
-            m_isFetching = false;
-            return;
-        }
+void AntigravityProvider::onServerStarted() {
+    m_hibernating = false;
+    m_discoveryDebounce.start(kDiscoveryDelayMs);
+}
 
-        QString output = QString::fromUtf8(process->readAllStandardOutput());
-        QStringList lines = output.split('\n');
-        
-        ProcessInfo foundInfo = {0, 0, "", ""};
-        bool found = false;
-
-        for (const QString &line : lines) {
-            // Check for correct process
-            // line format: "PID COMMAND_ARGS..." due to ps -ax -o pid=,command=
-            // But we can just fuzzy match for safety
-            if (!line.contains(kProcessName)) continue;
-            
-            // Should contain --app_data_dir and antigravity (common check)
-            if (!line.contains("--app_data_dir") || !line.contains("antigravity")) continue;
-
-            foundInfo = parseProcessLine(line);
-            if (!foundInfo.csrfToken.isEmpty()) {
-                found = true;
-                break;
-            }
-        }
+void AntigravityProvider::onRescanNeeded() {
+    // Live servers are rescanned by every scheduled refresh; the IDE
+    // writing into their data directories must not add scans of its own
+    if (!m_livePids.isEmpty()) return;
+    m_hibernating = false;
+    // At most one wake-up per delay, however busy the directory is
+    if (!m_discoveryDebounce.isActive()) m_discoveryDebounce.start(kDiscoveryDelayMs);
+}
 
-        if (found) {
-            findPorts(foundInfo);
-        } else {
-            qDebug() << "AntigravityProvider: Process not found";
-            setState(ProviderState::Error); 
-            m_isFetching = false;
-        }
-    });
+void AntigravityProvider::onServerExited(int pid) {
+    if (!m_livePids.remove(pid)) return;
+    qDebug() << "AntigravityProvider: Language server" << pid << "exited";
+
+    m_endpoints.remove(pid);
+    m_modelConfigs.remove(pid);
+    // Don't wait for its requests to time out
+    finishInstance(pid, QJsonObject());
 
-    process->start("ps", {"-ax", "-o", "pid=,command="});
+    if (m_livePids.isEmpty()) {
+        // Nothing left to poll; the last numbers are kept but marked stale
+        m_hibernating = true;
+        setState(ProviderState::Stale);
+    }
 }
 
-AntigravityProvider::ProcessInfo AntigravityProvider::parseProcessLine(const QString &line) {
+QList<AntigravityProvider::ProcessInfo> AntigravityProvider::detectProcesses() const {
+    QList<ProcessInfo> found;
+
+    for (const ProcessScanner::Process &process : ProcessScanner::find(kProcessName)) {
+        // Should contain --app_data_dir and antigravity (common check)
+        const QString commandLine = process.arguments.join(' ');
+        if (!process.arguments.contains("--app_data_dir") && !commandLine.contains("--app_data_dir=")) continue;
+        if (!commandLine.contains("antigravity")) continue;
+
+        ProcessInfo info = parseProcessArguments(process.pid, process.arguments);
+        info.startTime = process.startTime;
+        if (!info.appDataDir.isEmpty() && QDir::isRelativePath(info.appDataDir)) {
+            // Relative to the server's working directory, not ours
+            const QString cwd = QFileInfo(QString("/proc/%1/cwd").arg(process.pid)).symLinkTarget();
+            info.appDataDir = cwd.isEmpty() ? QString() : QDir(cwd).filePath(info.appDataDir);
+        }
+        if (!info.csrfToken.isEmpty()) found.append(info);
+    }
+    return found;
+}
+
+AntigravityProvider::ProcessInfo AntigravityProvider::parseProcessArguments(int pid, const QStringList &arguments) {
     ProcessInfo info = {0, 0, "", ""};
-    
-    // Extract PID
-    QString trimmed = line.trimmed();
-    int spaceIdx = trimmed.indexOf(' ');
-    if (spaceIdx == -1) return info;
-    
-    info.pid = trimmed.left(spaceIdx).toInt();
-    info.commandLine = trimmed.mid(spaceIdx + 1);
+    info.pid = pid;
+    info.commandLine = arguments.join(' ');
+
+    // "--flag value" or "--flag=value"
+    auto option = [&arguments](const QString &flag) -> QString {
+        const QString prefix = flag + '=';
+        for (int i = 0; i < arguments.size(); ++i) {
+            if (arguments[i] == flag && i + 1 < arguments.size()) return arguments[i + 1];
+            if (arguments[i].startsWith(prefix)) return arguments[i].mid(prefix.size());
+        }
+        return QString();
+    };
+
+    info.csrfToken = option("--csrf_token");
+    info.extensionPort = option("--extension_server_port").toInt();
+    info.appDataDir = option("--app_data_dir");
+
+    return info;
+}
 
-    // Extract CSRF Token
-    // --csrf_token <token>
-    static QRegularExpression csrfRegex(R"(--csrf_token[=\s]+([^\s]+))");
-    auto match = csrfRegex.match(info.commandLine);
-    if (match.hasMatch()) {
-        info.csrfToken = match.captured(1);
+void AntigravityProvider::fetchInstance(int pid) {
+    // Steady state: the same server is still up, skip port discovery entirely
+    auto it = m_endpoints.constFind(pid);
+    if (it != m_endpoints.cend() && it->isValid()) {
+        // Issued together: the network manager keeps the server's connection
+        // alive (HTTP/2 over HTTPS), so the extra calls add no round trips
+        const Endpoint endpoint = *it;
+        fetchUserStatus(pid, endpoint);
+        if (modelConfigsExpired(pid, endpoint.startTime)) fetchModelConfigs(pid, endpoint);
+    } else {
+        discoverInstance(pid);
     }
+}
+
+void AntigravityProvider::discoverInstance(int pid) {
+    const Instance *instance = pendingInstance(m_round, pid);
+    if (!instance) return;
 
-    // Extract Extension Port
-    static QRegularExpression portRegex(R"(--extension_server_port[=\s]+(\d+))");
-    auto portMatch = portRegex.match(info.commandLine);
-    if (portMatch.hasMatch()) {
-        info.extensionPort = portMatch.captured(1).toInt();
+    const QList<int> ports = findPorts(instance->info);
+    if (ports.isEmpty()) {
+        qDebug() << "AntigravityProvider: No listening ports found for PID" << pid;
+        finishInstance(pid, QJsonObject());
+        return;
     }
+    probePorts(pid, ports);
+}
 
-    return info;
+QList<int> AntigravityProvider::findPorts(const ProcessInfo &info) const {
+    QList<int> ports = ProcessScanner::listeningPorts(info.pid);
+
+    // Fallback to extension port if we have one (HTTP)
+    if (ports.isEmpty() && info.extensionPort > 0) {
+        ports << info.extensionPort;
+    }
+    return ports;
 }
 
-void AntigravityProvider::findPorts(const ProcessInfo &info) {
-    // Determine lsof binary
-    QString lsofMap = QStandardPaths::findExecutable("lsof");
-    if (lsofMap.isEmpty()) {
-        // Fallback or error?
-        // On many minimal linuxes lsof implies root or isn't there.
-        // We could try parsing /proc/net/tcp but mapping inodes to PIDs is hard without root.
-        // For now, assume user usually has lsof or we can try just extensionPort if available?
-        // The mac implementation falls back to extensionPort for HTTP.
-        // Let's force try extensionPort if lsof misses.
-        if (info.extensionPort > 0) {
-           QList<int> ports; 
-           ports << info.extensionPort;
-           probePorts(ports, info);
-           return;
+// Every port is tried over HTTPS and HTTP at once with GetUserStatus
+// itself, so the winning probe already carries the data. The first valid
+// Connect response wins and the other probes are cancelled.
+void AntigravityProvider::probePorts(int pid, const QList<int> &ports) {
+    const int round = m_round;
+    const ProcessInfo info = m_instances.value(pid).info;
+
+    QList<QPointer<HttpCall>> probes;
+    for (int port : ports) {
+        for (const QString scheme : {QStringLiteral("https"), QStringLiteral("http")}) {
+            Endpoint endpoint;
+            endpoint.pid = info.pid;
+            endpoint.startTime = info.startTime;
+            endpoint.port = port;
+            endpoint.scheme = scheme;
+            endpoint.csrfToken = info.csrfToken;
+
+            // Probes are not retried: a wrong port or scheme fails for good
+            HttpOptions options;
+            options.timeoutMs = kProbeTimeoutMs;
+            probes.append(postRpc(endpoint, kUserStatusPath, options, [this, round, pid, endpoint](const HttpResponse &response) {
+                // Lost the race, or an older refresh
+                const Instance *instance = pendingInstance(round, pid);
+                if (!instance || instance->hasStatus) return;
+                onProbeReply(pid, response, endpoint);
+            }));
         }
-        
-        qDebug() << "AntigravityProvider: lsof not found and no extension port known";
-        setState(ProviderState::Error);
-        m_isFetching = false;
+    }
+
+    if (Instance *instance = pendingInstance(round, pid)) {
+        instance->probes = probes;
+    }
+}
+
+void AntigravityProvider::onProbeReply(int pid, const HttpResponse &response, const Endpoint &endpoint) {
+    const QJsonObject userStatus = response.ok() ? parseUserStatus(response.body) : QJsonObject();
+
+    if (!userStatus.isEmpty()) {
+        qDebug() << "AntigravityProvider: PID" << pid << "uses" << endpoint.scheme << "port" << endpoint.port;
+        // Remember what worked, the next refresh goes straight here
+        m_endpoints.insert(pid, endpoint);
+        onUserStatus(pid, userStatus, endpoint);
         return;
     }
 
-    QProcess *lsof = new QProcess(this);
-    connect(lsof, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, lsof, info](int exitCode, QProcess::ExitStatus status) {
-        lsof->deleteLater();
-        // lsof returns 1 if no files found, which is possible.
-        
-        QString output = QString::fromUtf8(lsof->readAllStandardOutput());
-        QList<int> ports = parseLsofOutput(output);
-        
-        if (ports.isEmpty()) {
-             // Fallback to extraction port if we have one
-             if (info.extensionPort > 0) {
-                 ports << info.extensionPort;
-             } else {
-                 setState(ProviderState::Error);
-                 m_isFetching = false;
-                 return;
-             }
+    // Wait for the other probes unless this was the last one
+    for (const QPointer<HttpCall> &probe : std::as_const(m_instances[pid].probes)) {
+        if (probe && !probe->isFinished()) return;
+    }
+    qDebug() << "AntigravityProvider: No endpoint answered for PID" << pid << "-" << response.errorString;
+    finishInstance(pid, QJsonObject());
+}
+
+void AntigravityProvider::fetchUserStatus(int pid, const Endpoint &endpoint) {
+    const int round = m_round;
+
+    // A status read is safe to retry; the deadline guarantees m_isFetching is reset
+    HttpOptions options;
+    options.timeoutMs = kRequestTimeoutMs;
+    options.idempotent = true;
+    postRpc(endpoint, kUserStatusPath, options, [this, round, pid, endpoint](const HttpResponse &response) {
+        if (!pendingInstance(round, pid)) return;
+
+        const QJsonObject userStatus = response.ok() ? parseUserStatus(response.body) : QJsonObject();
+        if (userStatus.isEmpty()) {
+            // Restarted on another port or with a new token: rediscover once
+            qDebug() << "AntigravityProvider: Cached endpoint failed, rediscovering:" << response.errorString;
+            m_endpoints.remove(pid);
+            if (Instance *instance = pendingInstance(round, pid)) cancelSideCalls(*instance);
+            discoverInstance(pid);
+            return;
         }
-        
-        probePorts(ports, info);
+        onUserStatus(pid, userStatus, endpoint);
     });
+}
+
+void AntigravityProvider::onUserStatus(int pid, const QJsonObject &userStatus, const Endpoint &endpoint) {
+    Instance *instance = pendingInstance(m_round, pid);
+    if (!instance) return;
+
+    instance->hasStatus = true;
+    instance->userStatus = userStatus;
+    const QList<QPointer<HttpCall>> probes = std::exchange(instance->probes, {});
+    for (const QPointer<HttpCall> &probe : probes) {
+        if (probe) probe->cancel();
+    }
 
-    // lsof -nP -iTCP -sTCP:LISTEN -a -p <pid>
-    lsof->start(lsofMap, {"-nP", "-iTCP", "-sTCP:LISTEN", "-a", "-p", QString::number(info.pid)});
+    // Just discovered, or the status lacks configs or labels: fetch them now
+    if (!instance->configsRequested
+        && (modelConfigsExpired(pid, endpoint.startTime) || !hasCompleteModelConfigs(userStatus))) {
+        fetchModelConfigs(pid, endpoint);
+    }
+    if (instance->pendingSideCalls > 0) return;
+    finishInstance(pid, userStatus);
 }
 
-QList<int> AntigravityProvider::parseLsofOutput(const QString &output) {
-    QList<int> ports;
-    QStringList lines = output.split('\n');
-    // Example: process 123 user ... TCP 127.0.0.1:36559 (LISTEN)
-    // Regex looking for :(\d+)
-    static QRegularExpression portRegex(R"(:(\d+)\s+\(LISTEN\))");
-    
-    for (const QString &line : lines) {
-        auto match = portRegex.match(line);
-        if (match.hasMatch()) {
-            bool ok;
-            int p = match.captured(1).toInt(&ok);
-            if (ok && !ports.contains(p)) {
-                ports.append(p);
-            }
+bool AntigravityProvider::modelConfigsExpired(int pid, quint64 startTime) const {
+    auto it = m_modelConfigs.constFind(pid);
+    if (it == m_modelConfigs.cend() || it->startTime != startTime || it->fetchedMs == 0) return true;
+    return QDateTime::currentMSecsSinceEpoch() - it->fetchedMs > kModelConfigTtlMs;
+}
+
+void AntigravityProvider::fetchModelConfigs(int pid, const Endpoint &endpoint) {
+    const int round = m_round;
+    Instance *instance = pendingInstance(round, pid);
+    if (!instance) return;
+    instance->configsRequested = true;
+
+    HttpOptions options;
+    options.timeoutMs = kRequestTimeoutMs;
+    options.idempotent = true;
+    instance->pendingSideCalls++;
+    instance->sideCalls.append(postRpc(endpoint, kCommandModelPath, options, [this, round, pid](const HttpResponse &response) {
+        onModelConfigsReply(round, pid, response);
+    }));
+}
+
+void AntigravityProvider::onModelConfigsReply(int round, int pid, const HttpResponse &response) {
+    Instance *instance = pendingInstance(round, pid);
+    if (!instance || response.cancelled) return;
+
+    // proto3 JSON leaves out an empty list, so "{}" is a successful answer
+    const QJsonDocument document = response.ok() ? QJsonDocument::fromJson(response.body) : QJsonDocument();
+    if (!document.isObject()) {
+        // Not fatal: the status alone still has the quotas
+        qDebug() << "AntigravityProvider: GetCommandModelConfigs failed for PID" << pid << "-" << response.errorString;
+    } else {
+        ModelConfigs &configs = m_modelConfigs[pid];
+        if (configs.startTime != instance->info.startTime) {
+            configs = ModelConfigs();
+            configs.startTime = instance->info.startTime;
         }
+        // An empty list is cached for the TTL like any other
+        configs.clientModelConfigs = document.object().value("clientModelConfigs").toArray();
+        configs.fetchedMs = QDateTime::currentMSecsSinceEpoch();
+        configs.round = round;
+    }
+
+    if (--instance->pendingSideCalls == 0 && instance->hasStatus) {
+        finishInstance(pid, instance->userStatus);
     }
-    std::sort(ports.begin(), ports.end());
-    return ports;
 }
 
-// Simple probing: Try the first port. In a real scenario, we might iterate.
-// For expediency, if we have multiple, we'll try the first one that replies to Unleash, but
-// simplistic async logic is: Try one, if fail try next.
-// Here we'll just try to fetch UserStatus from the first one that looks like an API port.
-// Or just try specific ones.
-// The macOS probe tries them all for "GetUnleashData".
-void AntigravityProvider::probePorts(const QList<int> &ports, const ProcessInfo &info) {
-    // For MVP, if we have a port from lsof that matches extensionPort, prefer that?
-    // Actually the logic implies finding the *HTTPS* port which is random.
-    // extensionPort is HTTP.
-    
-    // We initiate a fetch on the first candidate. If it fails, we could chain.
-    // Let's implement a simple recursion or just try the first non-extension port?
-    
-    int targetPort = 0;
-    if (!ports.isEmpty()) targetPort = ports.first();
-    
-    // If we have an extension port, and we didn't find others, use it (HTTP).
-    // Ideally we iterate. Let's pick the last one (often newest?) or just the first.
-    
-    qDebug() << "AntigravityProvider: Fetching status from port" << targetPort;
-    fetchUserStatus(targetPort, info.csrfToken);
+// The calls went to an endpoint that stopped answering; they would only
+// hold the instance open until their retries and deadline ran out.
+// onUserStatus issues them again against the rediscovered endpoint.
+void AntigravityProvider::cancelSideCalls(Instance &instance) {
+    const QList<QPointer<HttpCall>> calls = std::exchange(instance.sideCalls, {});
+    instance.pendingSideCalls = 0;
+    instance.configsRequested = false;
+    for (const QPointer<HttpCall> &call : calls) {
+        if (call) call->cancel();
+    }
 }
 
-void AntigravityProvider::fetchUserStatus(int port, const QString &token) {
+HttpCall *AntigravityProvider::postRpc(const Endpoint &endpoint, const QString &path, const HttpOptions &options,
+                                       HttpCall::Callback callback) {
     QUrl url;
-    url.setScheme("https"); // Try HTTPS first (local server self-signed)
+    url.setScheme(endpoint.scheme);
     url.setHost("127.0.0.1");
-    url.setPort(port);
-    url.setPath(kUserStatusPath);
+    url.setPort(endpoint.port);
+    url.setPath(path);
     
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("X-Codeium-Csrf-Token", token.toUtf8());
+    request.setRawHeader("X-Codeium-Csrf-Token", endpoint.csrfToken.toUtf8());
     request.setRawHeader("Connect-Protocol-Version", "1");
     
     // Allow self-signed
@@ -225,33 +402,148 @@ void AntigravityProvider::fetchUserStatus(int port, const QString &token) {
     QJsonObject body;
     body["metadata"] = meta;
     
-    QNetworkReply *reply = m_nam->post(request, QJsonDocument(body).toJson());
-    connect(reply, &QNetworkReply::finished, this, [this, reply](){
-        onUserStatusReply(reply);
-    });
+    return HttpClient::instance()->post(request, QJsonDocument(body).toJson(), this, std::move(callback), options);
+}
+
+AntigravityProvider::Instance *AntigravityProvider::pendingInstance(int round, int pid) {
+    if (round != m_round) return nullptr;
+    auto it = m_instances.find(pid);
+    if (it == m_instances.end() || it->done) return nullptr;
+    return &it.value();
+}
+
+void AntigravityProvider::finishInstance(int pid, const QJsonObject &userStatus) {
+    Instance *instance = pendingInstance(m_round, pid);
+    if (!instance) return;
+
+    // Marked done first, so the cancelled calls' callbacks are ignored
+    instance->done = true;
+    instance->userStatus = userStatus;
+    auto cached = m_modelConfigs.constFind(pid);
+    if (!userStatus.isEmpty() && cached != m_modelConfigs.cend() && cached->startTime == instance->info.startTime) {
+        instance->userStatus = withModelConfigs(userStatus, *cached, cached->round == m_round);
+    }
+    QList<QPointer<HttpCall>> calls = std::exchange(instance->probes, {});
+    calls += std::exchange(instance->sideCalls, {});
+    for (const QPointer<HttpCall> &call : std::as_const(calls)) {
+        if (call) call->cancel();
+    }
+
+    for (const Instance &other : std::as_const(m_instances)) {
+        if (!other.done) return;
+    }
+    publishResults();
 }
 
-void AntigravityProvider::onUserStatusReply(QNetworkReply *reply) {
-    m_isFetching = false; 
-    reply->deleteLater();
+// Instances signed in to the same account report the same quota, possibly
+// sampled at different times: keep the worst value per limit. Several
+// accounts get their limits labelled with the account.
+void AntigravityProvider::publishResults() {
+    QMap<QString, QList<UsageLimit>> accounts;
+    for (const Instance &instance : std::as_const(m_instances)) {
+        if (instance.userStatus.isEmpty()) continue;
+
+        QList<UsageLimit> &merged = accounts[accountKey(instance.userStatus)];
+        for (const UsageLimit &limit : parseLimits(instance.userStatus)) {
+            auto it = std::find_if(merged.begin(), merged.end(), [&limit](const UsageLimit &existing) {
+                return existing.label == limit.label;
+            });
+            if (it == merged.end()) {
+                merged.append(limit);
+            } else if (limit.used > it->used) {
+                *it = limit;
+            }
+        }
+    }
+
+    m_isFetching = false;
+    m_instances.clear();
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "AntigravityProvider: API Error" << reply->errorString();
-        // Here we *could* retry with HTTP or another port
+    if (accounts.isEmpty()) {
         setState(ProviderState::Error);
         return;
     }
-    
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-    QJsonObject root = doc.object();
-    QJsonObject userStatus = root.value("userStatus").toObject();
-    
+
+    UsageSnapshot snap;
+    snap.timestamp = QDateTime::currentDateTime();
+    for (auto it = accounts.cbegin(); it != accounts.cend(); ++it) {
+        for (UsageLimit limit : it.value()) {
+            if (accounts.size() > 1 && !it.key().isEmpty()) {
+                limit.label = QString("%1 (%2)").arg(limit.label, it.key());
+            }
+            snap.limits.append(limit);
+        }
+    }
+
+    setSnapshot(snap);
+    setState(ProviderState::Active);
+}
+
+QJsonObject AntigravityProvider::parseUserStatus(const QByteArray &body) {
+    return QJsonDocument::fromJson(body).object().value("userStatus").toObject();
+}
+
+QString AntigravityProvider::accountKey(const QJsonObject &userStatus) {
+    return userStatus.value("email").toString();
+}
+
+QString AntigravityProvider::modelKey(const QJsonObject &config) {
+    const QJsonObject model = config.value("modelOrAlias").toObject();
+    const QString name = model.value("model").toString();
+    return name.isEmpty() ? model.value("alias").toString() : name;
+}
+
+bool AntigravityProvider::hasCompleteModelConfigs(const QJsonObject &userStatus) {
+    const QJsonArray list = userStatus.value("cascadeModelConfigData").toObject()
+                                      .value("clientModelConfigs").toArray();
+    if (list.isEmpty()) return false;
+    for (const QJsonValue &v : list) {
+        if (v.toObject().value("label").toString().isEmpty()) return false;
+    }
+    return true;
+}
+
+// Fills gaps in the status from GetCommandModelConfigs: labels missing on
+// single configs are looked up by model, and a status without any configs
+// takes the whole list. Quotas are only borrowed from a list fetched during
+// this refresh, never from the cache.
+QJsonObject AntigravityProvider::withModelConfigs(QJsonObject userStatus, const ModelConfigs &configs, bool fresh) {
+    if (configs.clientModelConfigs.isEmpty()) return userStatus;
+
+    QJsonObject data = userStatus.value("cascadeModelConfigData").toObject();
+    QJsonArray list = data.value("clientModelConfigs").toArray();
+    if (list.isEmpty()) {
+        if (!fresh) return userStatus;
+        list = configs.clientModelConfigs;
+    } else {
+        QHash<QString, QString> labels;
+        for (const QJsonValue &v : configs.clientModelConfigs) {
+            const QJsonObject c = v.toObject();
+            const QString key = modelKey(c);
+            const QString label = c.value("label").toString();
+            if (!key.isEmpty() && !label.isEmpty()) labels.insert(key, label);
+        }
+        for (qsizetype i = 0; i < list.size(); ++i) {
+            QJsonObject c = list.at(i).toObject();
+            if (!c.value("label").toString().isEmpty()) continue;
+            const QString label = labels.value(modelKey(c));
+            if (label.isEmpty()) continue;
+            c["label"] = label;
+            list.replace(i, c);
+        }
+    }
+
+    data["clientModelConfigs"] = list;
+    userStatus["cascadeModelConfigData"] = data;
+    return userStatus;
+}
+
+QList<UsageLimit> AntigravityProvider::parseLimits(const QJsonObject &userStatus) {
     // Parse mapping
     QJsonArray clientConfigs = userStatus.value("cascadeModelConfigData").toObject()
                                          .value("clientModelConfigs").toArray();
                                          
-    UsageSnapshot snap;
-    snap.limits.clear();
+    QList<UsageLimit> limits;
     
     // Simple mapping strategy from docs
     // 1. Claude
@@ -311,7 +603,7 @@ void AntigravityProvider::onUserStatusReply(QNetworkReply *reply) {
                         limit.resetDescription = QString("Resets in %1m").arg(mins);
                 }
             }
-            snap.limits.append(limit);
+            limits.append(limit);
         }
     };
     
@@ -319,11 +611,5 @@ void AntigravityProvider::onUserStatusReply(QNetworkReply *reply) {
     addLimit(findModel("claude", "thinking"), "Claude");
     addLimit(findModel("flash"), "Flash");
     
-    setSnapshot(snap);
-    setState(ProviderState::Active);
-}
-
-void AntigravityProvider::onCommandModelConfigReply(QNetworkReply *reply) {
-    // Fallback path if needed
-    reply->deleteLater();
+    return limits;
 }
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "Provider.h"
-#include <QNetworkAccessManager>
-#include <QProcess>
+#include "HttpClient.h"
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+
+class ProcessWatcher;
 
 class AntigravityProvider : public Provider {
     Q_OBJECT
@@ -12,16 +19,47 @@ public:
 
     void refresh() override;
 
-private slots:
-    void onUserStatusReply(QNetworkReply *reply);
-    void onCommandModelConfigReply(QNetworkReply *reply);
-
 private:
     struct ProcessInfo {
         int pid;
         int extensionPort;
         QString csrfToken;
         QString commandLine;
+        quint64 startTime = 0;
+        QString appDataDir;
+    };
+
+    // Last endpoint that answered; reused while the same process is up
+    struct Endpoint {
+        int pid = 0;
+        quint64 startTime = 0;
+        int port = 0;
+        QString scheme;
+        QString csrfToken;
+
+        bool isValid() const { return port > 0; }
+    };
+
+    // Model configs change far less often than quotas,
+    // so they are fetched at most once per TTL for each server
+    struct ModelConfigs {
+        quint64 startTime = 0;
+        qint64 fetchedMs = 0; // 0 until GetCommandModelConfigs answered
+        int round = 0;        // Refresh that fetched them
+        QJsonArray clientModelConfigs;
+    };
+
+    // One language server (one per IDE window) within the current refresh
+    struct Instance {
+        ProcessInfo info;
+        QList<QPointer<HttpCall>> probes;
+        // GetCommandModelConfigs running next to GetUserStatus
+        QList<QPointer<HttpCall>> sideCalls;
+        int pendingSideCalls = 0;
+        bool configsRequested = false;
+        bool hasStatus = false;
+        QJsonObject userStatus; // Empty when the instance failed
+        bool done = false;
     };
 
     struct LimitInfo {
@@ -29,17 +67,51 @@ private:
         QString resetTime;
     };
 
-    QNetworkAccessManager *m_nam;
     bool m_isFetching;
+    // Working endpoints by PID, dropped when their process goes away
+    QHash<int, Endpoint> m_endpoints;
+    // Cached model configs by PID, pruned together with the endpoints
+    QHash<int, ModelConfigs> m_modelConfigs;
+    // Instances queried by the running refresh, by PID
+    QHash<int, Instance> m_instances;
+    int m_round = 0;
+
+    // Servers seen by the last scan; once the last one exits the provider
+    // hibernates until the watcher reports a new one
+    ProcessWatcher *m_watcher;
+    QSet<int> m_livePids;
+    bool m_hibernating = false;
+    int m_skippedScans = 0;
+    QTimer m_discoveryDebounce;
 
     // Helper steps
-    void detectProcess();
-    void findPorts(const ProcessInfo &info);
-    void probePorts(const QList<int> &ports, const ProcessInfo &info);
-    void fetchUserStatus(int port, const QString &token);
-    void fetchCommandModelConfig(int port, const QString &token);
+    void onServerStarted();
+    void onRescanNeeded();
+    void onServerExited(int pid);
+    QList<ProcessInfo> detectProcesses() const;
+    void fetchInstance(int pid);
+    void discoverInstance(int pid);
+    QList<int> findPorts(const ProcessInfo &info) const;
+    void probePorts(int pid, const QList<int> &ports);
+    void onProbeReply(int pid, const HttpResponse &response, const Endpoint &endpoint);
+    void fetchUserStatus(int pid, const Endpoint &endpoint);
+    void onUserStatus(int pid, const QJsonObject &userStatus, const Endpoint &endpoint);
+    bool modelConfigsExpired(int pid, quint64 startTime) const;
+    void fetchModelConfigs(int pid, const Endpoint &endpoint);
+    void onModelConfigsReply(int round, int pid, const HttpResponse &response);
+    void cancelSideCalls(Instance &instance);
+    HttpCall *postRpc(const Endpoint &endpoint, const QString &path, const HttpOptions &options,
+                      HttpCall::Callback callback);
+    Instance *pendingInstance(int round, int pid);
+    void finishInstance(int pid, const QJsonObject &userStatus);
+    void publishResults();
 
     // Utilities
-    static ProcessInfo parseProcessLine(const QString &line);
-    static QList<int> parseLsofOutput(const QString &output);
+    static ProcessInfo parseProcessArguments(int pid, const QStringList &arguments);
+    static QJsonObject parseUserStatus(const QByteArray &body);
+    static QString accountKey(const QJsonObject &userStatus);
+    static QString modelKey(const QJsonObject &config);
+    static bool hasCompleteModelConfigs(const QJsonObject &userStatus);
+    static QJsonObject withModelConfigs(QJsonObject userStatus, const ModelConfigs &configs, bool fresh);
+    static QList<UsageLimit> parseLimits(const QJsonObject &userStatus);
 };
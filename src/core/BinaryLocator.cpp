@@ -0,0 +1,135 @@
+#include "BinaryLocator.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTimer>
+
+// Some shells print greetings or run slow plugins on login
+static constexpr int kShellTimeoutMs = 5000;
+
+BinaryLocator *BinaryLocator::instance() {
+    static BinaryLocator *locator = nullptr;
+    if (!locator) {
+        locator = new BinaryLocator(QCoreApplication::instance());
+    }
+    return locator;
+}
+
+BinaryLocator::BinaryLocator(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &BinaryLocator::onDirectoryChanged);
+    setSearchPaths({});
+}
+
+void BinaryLocator::captureLoginShellPath() {
+    if (m_shell) return;
+
+    QString shell = qEnvironmentVariable("SHELL");
+    if (shell.isEmpty()) shell = "/bin/sh";
+
+    QProcess *process = new QProcess(this);
+    m_shell = process;
+    process->setStandardInputFile(QProcess::nullDevice());
+    process->setStandardErrorFile(QProcess::nullDevice());
+
+    connect(process, &QProcess::finished, this, [this, process](int exitCode, QProcess::ExitStatus status) {
+        const QByteArray output = process->readAllStandardOutput();
+        process->deleteLater();
+        m_shell = nullptr;
+
+        if (status != QProcess::NormalExit || exitCode != 0) {
+            qDebug() << "BinaryLocator: login shell failed, keeping inherited PATH";
+            return;
+        }
+
+        // `env` output, possibly preceded by whatever the profile printed.
+        // Every shell (fish included) exports PATH colon-separated.
+        QString loginPath;
+        for (const QByteArray &line : output.split('\n')) {
+            if (line.startsWith("PATH=")) loginPath = QString::fromLocal8Bit(line.mid(5));
+        }
+        if (loginPath.isEmpty()) return;
+
+        setSearchPaths(loginPath.split(':', Qt::SkipEmptyParts));
+        // Children (claude runs on node, found through PATH) see it too
+        qputenv("PATH", m_searchPaths.join(':').toLocal8Bit());
+        qDebug() << "BinaryLocator: using login shell PATH" << m_searchPaths;
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) return;
+        qDebug() << "BinaryLocator: could not start login shell";
+        process->deleteLater();
+        m_shell = nullptr;
+    });
+
+    process->start(shell, {"-l", "-c", "env"});
+    QTimer::singleShot(kShellTimeoutMs, process, [process]() {
+        qDebug() << "BinaryLocator: login shell timed out";
+        process->kill();
+    });
+}
+
+QString BinaryLocator::find(const QString &name) {
+    auto it = m_cache.constFind(name);
+    if (it != m_cache.cend()) return it.value();
+
+    const QString path = QStandardPaths::findExecutable(name, m_searchPaths);
+    m_cache.insert(name, path);
+    if (path.isEmpty()) {
+        qDebug() << "BinaryLocator:" << name << "not found";
+    }
+    return path;
+}
+
+void BinaryLocator::setSearchPaths(const QStringList &loginPaths) {
+    const QString home = QDir::homePath();
+    QStringList candidates = loginPaths;
+    candidates += qEnvironmentVariable("PATH").split(':', Qt::SkipEmptyParts);
+    // Usual install locations that a desktop session's PATH tends to miss
+    candidates += {
+        home + "/.local/bin",
+        home + "/.npm/bin",
+        home + "/.npm-global/bin",
+        "/opt/claude-code/bin",
+        "/usr/local/bin",
+        "/usr/bin",
+        "/bin",
+        "/usr/sbin",
+        "/sbin",
+    };
+
+    QStringList paths;
+    for (const QString &candidate : std::as_const(candidates)) {
+        const QString dir = QDir::cleanPath(candidate);
+        if (!paths.contains(dir)) paths.append(dir);
+    }
+
+    const QStringList watched = m_watcher.directories();
+    if (!watched.isEmpty()) m_watcher.removePaths(watched);
+    for (const QString &dir : std::as_const(paths)) {
+        // Directories created later are not picked up until the next capture
+        if (QFileInfo(dir).isDir()) m_watcher.addPath(dir);
+    }
+
+    m_searchPaths = paths;
+    m_cache.clear();
+    emit searchPathsChanged();
+}
+
+void BinaryLocator::onDirectoryChanged(const QString &dir) {
+    // A tool appearing here may shadow one found further down the PATH, and
+    // any miss may now resolve; everything else stays valid
+    for (auto it = m_cache.begin(); it != m_cache.end();) {
+        const QString &path = it.value();
+        if (path.isEmpty() || QFileInfo(path).absolutePath() == dir
+            || m_searchPaths.indexOf(dir) < m_searchPaths.indexOf(QFileInfo(path).absolutePath())) {
+            it = m_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+class QProcess;
+
+// Resolves command-line tools the way the user's terminal would. Desktop
+// sessions often start the tray with a minimal PATH, so the login shell's
+// PATH is captured once at startup. Lookups are cached, and the search
+// directories are watched so installs, upgrades and uninstalls drop the
+// affected entries instead of every refresh walking the filesystem.
+class BinaryLocator : public QObject {
+    Q_OBJECT
+public:
+    static BinaryLocator *instance();
+
+    // Ask the login shell for its PATH in the background; lookups made
+    // before it answers use the inherited PATH plus the fallback dirs
+    void captureLoginShellPath();
+
+    // Absolute path, or empty when the tool is not installed
+    QString find(const QString &name);
+
+    QStringList searchPaths() const { return m_searchPaths; }
+
+signals:
+    void searchPathsChanged();
+
+private:
+    explicit BinaryLocator(QObject *parent = nullptr);
+
+    void setSearchPaths(const QStringList &loginPaths);
+    void onDirectoryChanged(const QString &dir);
+
+    QStringList m_searchPaths;
+    QHash<QString, QString> m_cache; // Misses are cached as empty strings
+    QFileSystemWatcher m_watcher;
+    QProcess *m_shell = nullptr;
+};
@@ -1,8 +1,7 @@
 #include "ClaudeProvider.h"
+#include "BinaryLocator.h"
 #include <QDebug>
-#include <QRegularExpression>
-#include <QDir>
-#include <QStandardPaths>
+#include <QSettings>
 
 ClaudeProvider::ClaudeProvider(QObject *parent)
     : Provider(ProviderID::Claude, parent)
@@ -10,6 +9,9 @@ ClaudeProvider::ClaudeProvider(QObject *parent)
     , m_fetching(false)
     , m_statusSent(false)
     , m_arrowsSent(0)
+    , m_warm(false)
+    , m_readyLatency("claude.ready")
+    , m_snapshotLatency("claude.snapshot")
 {
     m_debounce.setSingleShot(true);
     connect(&m_debounce, &QTimer::timeout, this, &ClaudeProvider::sendStatus);
@@ -17,35 +19,57 @@ ClaudeProvider::ClaudeProvider(QObject *parent)
     m_timeout.setSingleShot(true);
     connect(&m_timeout, &QTimer::timeout, this, [this]() {
         qDebug() << "ClaudeProvider: Session timed out, forcing cleanup";
+        // Keep whatever part of the usage panel did render
+        publishUsage();
         cleanup();
         m_fetching = false;
     });
 }
 
 void ClaudeProvider::refresh() {
-    if (m_fetching) return;
-
-    // Find claude binary — desktop launches may have a limited PATH
-    QString claudePath = QStandardPaths::findExecutable("claude");
-    if (claudePath.isEmpty()) {
-        const QStringList extraPaths = {
-            QDir::homePath() + "/.local/bin",
-            QDir::homePath() + "/.npm/bin",
-            "/opt/claude-code/bin",
-            "/usr/local/bin",
-        };
-        claudePath = QStandardPaths::findExecutable("claude", extraPaths);
+    if (m_fetching) {
+        emit refreshSkipped();
+        return;
     }
-    if (claudePath.isEmpty()) {
-        setState(ProviderState::Error);
-        emit dataChanged();
+
+    // Setting was switched off while a session was kept warm
+    if (m_warm && !keepSessionAlive()) cleanup();
+
+    // Reuse the idle session: reopen /status instead of respawning claude
+    if (m_warm && m_session && m_session->isRunning()) {
+        m_refreshTimer.start();
+        m_warm = false;
+        m_fetching = true;
+        m_statusSent = true;
+        m_arrowsSent = 0;
+        m_usage.reset();
+        m_screen.clearDirty();
+        m_timeout.start(10000);
+        m_session->write("/status\r");
         return;
     }
 
+    // Replay a recorded session instead of running claude (profiling, regressions)
+    const QString replayPath = qEnvironmentVariable("CODEXBAR_CLAUDE_REPLAY");
+
+    // Find claude binary — cached, and resolved against the login shell's PATH
+    QString claudePath;
+    if (replayPath.isEmpty()) {
+        claudePath = BinaryLocator::instance()->find("claude");
+        if (claudePath.isEmpty()) {
+            setState(ProviderState::Error);
+            emit dataChanged();
+            return;
+        }
+    }
+
+    m_refreshTimer.start();
     m_fetching = true;
     m_statusSent = false;
     m_arrowsSent = 0;
-    m_buffer.clear();
+    m_dismissedDialog = Dialog::None;
+    m_settling = false;
+    m_usage.reset();
     m_debounce.stop();
     m_timeout.stop();
     cleanup();
@@ -55,75 +79,136 @@ void ClaudeProvider::refresh() {
     connect(m_session, &PtySession::dataRead, this, &ClaudeProvider::onPtyData);
     connect(m_session, &PtySession::processExited, this, &ClaudeProvider::onProcessExited);
 
-    if (!m_session->start(claudePath, {})) {
+    bool started;
+    if (replayPath.isEmpty()) {
+        started = m_session->start(claudePath, {});
+    } else {
+        const auto speed = qEnvironmentVariableIsSet("CODEXBAR_REPLAY_FAST")
+            ? PtySession::ReplaySpeed::AsFastAsPossible
+            : PtySession::ReplaySpeed::Recorded;
+        started = m_session->startReplay(replayPath, speed);
+    }
+
+    if (!started) {
         setState(ProviderState::Error);
         cleanup();
         m_fetching = false;
         emit dataChanged();
+        return;
     }
+
+    // Transcripts carry their own terminal size
+    m_screen.resize(m_session->rows(), m_session->columns());
 }
 
 void ClaudeProvider::onPtyData(const QByteArray &data) {
     if (!m_session) return;
-    m_buffer.append(QString::fromUtf8(data));
 
-    // Before /status is sent, debounce — wait for output to settle
-    // so we don't send commands into the welcome animation
-    if (!m_statusSent) {
-        m_debounce.start(1500);
-        return;
-    }
+    // Keep the screen in sync even while idle — a warm session redraws incrementally
+    m_screen.feed(data);
+    if (m_warm) return;
 
-    // Strip ANSI for detection purposes
-    static QRegularExpression ansiRx(R"(\x1B(?:[@-Z\\-_]|\[[0-?]*[ -/]*[@-~]))");
-    QString stripped = m_buffer;
-    stripped.remove(ansiRx);
-
-    // First right arrow when tab bar appears (Status → Config)
-    if (m_arrowsSent == 0 && stripped.contains("Config") && stripped.contains("Usage")) {
-        m_session->write("\x1b[C");
-        m_arrowsSent = 1;
-        return;
-    }
+    // Before /status is sent, react as soon as the screen shows a dialog or
+    // the input prompt. Waiting for output to settle (so we don't send
+    // commands into the welcome animation) is only the fallback.
+    if (!m_statusSent) {
+        if (m_dismissedDialog != Dialog::None && visibleDialog(false) != m_dismissedDialog)
+            m_dismissedDialog = Dialog::None;
 
-    // Second right arrow when Config tab content appears (Config → Usage)
-    if (m_arrowsSent == 1 && stripped.contains("Auto-compact")) {
-        m_session->write("\x1b[C");
-        m_arrowsSent = 2;
+        // One Enter per dialog: a second one would confirm the next screen blind
+        const Dialog dialog = visibleDialog(true);
+        if (dialog != Dialog::None && dialog != m_dismissedDialog) {
+            dismissDialog(dialog);
+            m_screen.clearDirty();
+        } else if (promptVisible()) {
+            m_debounce.stop();
+            sendStatus();
+        } else if (!m_settling) {
+            m_debounce.start(1500);
+        }
         return;
     }
 
-    // Parse usage data when available
-    if (m_arrowsSent == 2) {
-        parseOutput(m_buffer);
+    // Detection only looks at rows redrawn since the previous chunk
+    if (m_arrowsSent == 0) {
+        // First right arrow when tab bar appears (Status → Config)
+        if (m_screen.dirtyRowsContain("Config") && m_screen.dirtyRowsContain("Usage")) {
+            m_session->write("\x1b[C");
+            m_arrowsSent = 1;
+        }
+    } else if (m_arrowsSent == 1) {
+        // Second right arrow when Config tab content appears (Config → Usage)
+        if (m_screen.dirtyRowsContain("Auto-compact")) {
+            m_session->write("\x1b[C");
+            m_arrowsSent = 2;
+        }
+    } else if (m_arrowsSent == 2) {
+        // Tokenize only the rows this chunk redrew, stop once every limit is in
+        const QList<int> rows = m_screen.dirtyRows();
+        for (int row : rows) {
+            m_usage.updateRow(row, m_screen.rowText(row));
+        }
+        if (!rows.isEmpty() && m_usage.isComplete()) {
+            m_arrowsSent = 3; // Done, ignore further redraws
+            publishUsage();
+            m_snapshotLatency.record(m_refreshTimer.elapsed());
+            qDebug() << "ClaudeProvider:" << m_readyLatency.summary() << "|" << m_snapshotLatency.summary();
+            // Defer cleanup to next event loop iteration — we're inside a PtySession signal
+            QTimer::singleShot(0, this, &ClaudeProvider::finishRefresh);
+        }
     }
+    m_screen.clearDirty();
 }
 
 void ClaudeProvider::sendStatus() {
     if (!m_session || m_statusSent) return;
+    m_settling = false;
 
-    // Strip ANSI to check buffer content
-    static QRegularExpression ansiRx(R"(\x1B(?:[@-Z\\-_]|\[[0-?]*[ -/]*[@-~]))");
-    QString stripped = m_buffer;
-    stripped.remove(ansiRx);
-
-    // Dismiss interactive dialogs that block the prompt
-    // Theme picker (first-run) or workspace trust dialog
-    if (stripped.contains("Darkmode") && stripped.contains("Lightmode")) {
-        m_buffer.clear();
-        m_session->write("\r");
-        m_debounce.start(3000);
-        return;
-    }
-    if (stripped.contains("Itrustthisfolder") || stripped.contains("trustthisfolder")) {
-        m_buffer.clear();
-        m_session->write("\r");
-        m_debounce.start(3000);
+    // Dismiss interactive dialogs that block the prompt. This also retries
+    // a dialog that is still up after the post-dismiss wait.
+    const Dialog dialog = visibleDialog(false);
+    if (dialog != Dialog::None) {
+        dismissDialog(dialog);
         return;
     }
 
     m_session->write("/status\r");
     m_statusSent = true;
+    m_screen.clearDirty();
+    m_readyLatency.record(m_refreshTimer.elapsed());
+}
+
+void ClaudeProvider::dismissDialog(Dialog dialog) {
+    m_session->write("\r");
+    m_dismissedDialog = dialog;
+    m_settling = true;
+    m_debounce.start(3000);
+}
+
+ClaudeProvider::Dialog ClaudeProvider::visibleDialog(bool changedRowsOnly) const {
+    auto visible = [&](const QString &text, Qt::CaseSensitivity cs = Qt::CaseSensitive) {
+        return changedRowsOnly ? m_screen.dirtyRowsContain(text, cs) : m_screen.contains(text, cs);
+    };
+    // Theme picker (first-run) or workspace trust dialog
+    if (visible("Dark mode") && visible("Light mode")) return Dialog::Theme;
+    if (visible("trust this folder", Qt::CaseInsensitive)) return Dialog::Trust;
+    return Dialog::None;
+}
+
+bool ClaudeProvider::promptVisible() const {
+    // The input box is drawn as "> " (inside a border) with a shortcuts hint below
+    const QList<int> rows = m_screen.dirtyRows();
+    for (int row : rows) {
+        const QString text = m_screen.rowText(row);
+        if (text.contains("? for shortcuts")) return true;
+
+        QStringView body = QStringView(text).trimmed();
+        while (!body.isEmpty() && body.front() == u'│') body = body.mid(1).trimmed();
+        while (!body.isEmpty() && body.back() == u'│') body.chop(1);
+        body = body.trimmed();
+        if (body == u">" || body.startsWith(u"> ")) return true;
+    }
+    return false;
 }
 
 void ClaudeProvider::onProcessExited(int exitCode) {
@@ -134,113 +219,47 @@ void ClaudeProvider::onProcessExited(int exitCode) {
     m_fetching = false;
 }
 
+bool ClaudeProvider::keepSessionAlive() const {
+    return QSettings("KDECodexBar", "KDECodexBar").value("claude_keep_session", false).toBool();
+}
+
 void ClaudeProvider::cleanup() {
+    m_warm = false;
     if (m_session) {
         PtySession *s = m_session;
         m_session = nullptr;
-        s->close();
-        s->deleteLater();
+        // Detach first: the exit of this child must not disturb a newer session
+        disconnect(s, nullptr, this, nullptr);
+        if (s->isRunning()) {
+            // Reaping is asynchronous, free the session once the child is gone
+            connect(s, &PtySession::processExited, s, &QObject::deleteLater);
+            s->close();
+        } else {
+            s->deleteLater();
+        }
     }
 }
 
-void ClaudeProvider::parseOutput(const QString &output) {
-    // Remove ANSI escape codes
-    static QRegularExpression ansiRegex(R"(\x1B(?:[@-Z\\-_]|\[[0-?]*[ -/]*[@-~]))");
-    QString clean = output;
-    clean.remove(ansiRegex);
-
-    // Match usage entries: label followed by N% used, optionally followed by reset info
-    // After ANSI stripping, text may lose spaces, so "Resets" can appear as "Rese(t|s)s" etc.
-    static QRegularExpression usageRegex(
-        R"((Current\s*session|Current\s*week\s*\(all\s*models\)|Current\s*week\s*\(Sonnet\s*only\)|Extra\s*usage)[^%]*?(\d{1,3})\s*%\s*used\s*(Rese[^\(]*\([^\)]+\))?)",
-        QRegularExpression::CaseInsensitiveOption
-    );
-
+void ClaudeProvider::publishUsage() {
     UsageSnapshot snap;
     snap.timestamp = QDateTime::currentDateTime();
-    bool found = false;
-
-    auto it = usageRegex.globalMatch(clean);
-    while (it.hasNext()) {
-        auto match = it.next();
-        QString rawLabel = match.captured(1);
-        double val = match.captured(2).toDouble();
-        QString rawReset = match.captured(3).trimmed();
-
-        UsageLimit limit;
-        if (rawLabel.startsWith("Current session", Qt::CaseInsensitive) ||
-            rawLabel.startsWith("Currentsession", Qt::CaseInsensitive))
-            limit.label = "Session";
-        else if (rawLabel.contains("all models", Qt::CaseInsensitive) ||
-                 rawLabel.contains("allmodels", Qt::CaseInsensitive))
-            limit.label = "Weekly (all)";
-        else if (rawLabel.contains("Sonnet only", Qt::CaseInsensitive) ||
-                 rawLabel.contains("Sonnetonly", Qt::CaseInsensitive))
-            limit.label = "Weekly (Sonnet)";
-        else if (rawLabel.startsWith("Extra", Qt::CaseInsensitive))
-            limit.label = "Extra";
-
-        limit.used = val;
-        limit.total = 100.0;
-        if (!rawReset.isEmpty()) {
-            // Remove timezone like "(Europe/Bucharest)" and normalize prefix
-            rawReset.replace(QRegularExpression(R"(\s*\([A-Za-z]+/[A-Za-z_]+\))"), "");
-            rawReset.replace(QRegularExpression(R"(^Rese\w*s\s*)", QRegularExpression::CaseInsensitiveOption), "");
-            QString timeStr = rawReset.simplified();
-
-            // Parse absolute time from Claude CLI into relative "Resets in Xh Ym"
-            // Formats: "5pm", "9:59am", "Apr 10, 9:59am", "Apr 10, 5pm"
-            QDateTime resetDt;
-            static QRegularExpression dateTimeRx(R"(^([A-Za-z]+)\s+(\d{1,2}),?\s+(.+)$)");
-            auto dtMatch = dateTimeRx.match(timeStr);
-            if (dtMatch.hasMatch()) {
-                // Has date component: "Apr 10, 9:59am"
-                QString monthDay = dtMatch.captured(1) + " " + dtMatch.captured(2);
-                QString timePart = dtMatch.captured(3).trimmed();
-                // Try with minutes then without
-                resetDt = QDateTime::fromString(
-                    QString("%1 %2 %3").arg(QDate::currentDate().year()).arg(monthDay).arg(timePart),
-                    "yyyy MMM d h:mmap");
-                if (!resetDt.isValid())
-                    resetDt = QDateTime::fromString(
-                        QString("%1 %2 %3").arg(QDate::currentDate().year()).arg(monthDay).arg(timePart),
-                        "yyyy MMM d hap");
-            } else {
-                // Time only: "5pm", "9:59am" — assume today
-                QTime t = QTime::fromString(timeStr, "h:mmap");
-                if (!t.isValid()) t = QTime::fromString(timeStr, "hap");
-                if (t.isValid()) resetDt = QDateTime(QDate::currentDate(), t);
-            }
-
-            if (resetDt.isValid()) {
-                qint64 secsLeft = QDateTime::currentDateTime().secsTo(resetDt);
-                if (secsLeft > 0) {
-                    int days = secsLeft / 86400;
-                    int hours = (secsLeft % 86400) / 3600;
-                    int mins = (secsLeft % 3600) / 60;
-                    if (days > 0)
-                        limit.resetDescription = QString("Resets in %1d %2h").arg(days).arg(hours);
-                    else if (hours > 0)
-                        limit.resetDescription = QString("Resets in %1h %2m").arg(hours).arg(mins);
-                    else
-                        limit.resetDescription = QString("Resets in %1m").arg(mins);
-                }
-            }
-        }
-        snap.limits.append(limit);
-        found = true;
-    }
+    snap.limits = m_usage.limits();
+    if (snap.limits.isEmpty()) return;
 
-    if (found) {
-        setSnapshot(snap);
-        setState(ProviderState::Active);
-        emit dataChanged();
+    setSnapshot(snap);
+    setState(ProviderState::Active);
+    emit dataChanged();
+}
 
-        // Defer cleanup to next event loop iteration — we're inside a PtySession signal
-        QTimer::singleShot(0, this, [this]() {
-            m_timeout.stop();
-            cleanup();
-            m_fetching = false;
-        });
+void ClaudeProvider::finishRefresh() {
+    if (!m_fetching) return; // Already finished by an earlier chunk
+    m_timeout.stop();
+    if (m_session && keepSessionAlive()) {
+        // Close the panel with Escape and keep claude idle for the next refresh
+        m_session->write("\x1b");
+        m_warm = true;
+    } else {
+        cleanup();
     }
+    m_fetching = false;
 }
@@ -2,7 +2,10 @@
 
 #include "Provider.h"
 #include "PtySession.h"
-#include <QRegularExpression>
+#include "TerminalScreen.h"
+#include "ClaudeUsageParser.h"
+#include "LatencyHistogram.h"
+#include <QElapsedTimer>
 #include <QTimer>
 
 class ClaudeProvider : public Provider {
@@ -11,21 +14,46 @@ public:
     explicit ClaudeProvider(QObject *parent = nullptr);
 
     void refresh() override;
+    bool spawnsProcess() const override { return true; }
 
 private slots:
     void onPtyData(const QByteArray &data);
     void onProcessExited(int exitCode);
 
 private:
+    enum class Dialog {
+        None,
+        Theme,
+        Trust
+    };
+
     void sendStatus();
-    void parseOutput(const QString &output);
+    void dismissDialog(Dialog dialog);
+    Dialog visibleDialog(bool changedRowsOnly) const;
+    bool promptVisible() const;
+    void publishUsage();
+    void finishRefresh();
     void cleanup();
+    bool keepSessionAlive() const;
 
     PtySession *m_session;
     QTimer m_debounce;
     QTimer m_timeout;
-    QString m_buffer;
+    TerminalScreen m_screen;
+    ClaudeUsageParser m_usage;
     bool m_fetching;
     bool m_statusSent;
     int m_arrowsSent;
+    // Dialog already answered with Enter, until it leaves the screen.
+    // Ink redraws whole frames, so it is seen again on later chunks.
+    Dialog m_dismissedDialog = Dialog::None;
+    // Post-dismiss wait is running; output must not shorten it
+    bool m_settling = false;
+    // Opt-in: session sits idle at the prompt between refreshes
+    bool m_warm;
+
+    // Time from refresh() to /status being sent, and to a complete snapshot
+    QElapsedTimer m_refreshTimer;
+    LatencyHistogram m_readyLatency;
+    LatencyHistogram m_snapshotLatency;
 };
@@ -0,0 +1,228 @@
+#include "ClaudeUsageParser.h"
+#include <QStringList>
+
+void ClaudeUsageParser::reset() {
+    m_rows.clear();
+}
+
+void ClaudeUsageParser::updateRow(int row, QStringView text) {
+    RowTokens tokens = tokenize(text);
+    if (tokens.section == Section::None && tokens.percent < 0 && tokens.reset.isEmpty() && !tokens.footer) {
+        m_rows.remove(row);
+    } else {
+        m_rows.insert(row, tokens);
+    }
+}
+
+ClaudeUsageParser::RowTokens ClaudeUsageParser::tokenize(QStringView text) {
+    RowTokens tokens;
+
+    // Skip panel borders and indentation
+    qsizetype start = 0;
+    while (start < text.size() && !text.at(start).isLetterOrNumber()) ++start;
+    const QStringView body = text.mid(start);
+    if (body.isEmpty()) return tokens;
+
+    // Section header
+    if (body.startsWith(u"Current session", Qt::CaseInsensitive)) {
+        tokens.section = Section::Session;
+    } else if (body.startsWith(u"Current week", Qt::CaseInsensitive)) {
+        if (body.contains(u"all models", Qt::CaseInsensitive))
+            tokens.section = Section::WeeklyAll;
+        else if (body.contains(u"Sonnet", Qt::CaseInsensitive))
+            tokens.section = Section::WeeklySonnet;
+    } else if (body.startsWith(u"Extra usage", Qt::CaseInsensitive)) {
+        tokens.section = Section::Extra;
+    } else if (body.startsWith(u"Esc to", Qt::CaseInsensitive)) {
+        tokens.footer = true;
+        return tokens;
+    }
+
+    // "NN% used" — digits directly before the '%', "used" after it
+    for (qsizetype pos = body.indexOf(u'%'); pos > 0; pos = body.indexOf(u'%', pos + 1)) {
+        qsizetype after = pos + 1;
+        while (after < body.size() && body.at(after).isSpace()) ++after;
+        if (!body.mid(after).startsWith(u"used", Qt::CaseInsensitive)) continue;
+
+        qsizetype digits = pos;
+        while (digits > 0 && body.at(digits - 1).isSpace()) --digits;
+        qsizetype end = digits;
+        while (digits > 0 && end - digits < 3 && body.at(digits - 1).isDigit()) --digits;
+        if (digits == end) continue;
+
+        tokens.percent = body.mid(digits, end - digits).toInt();
+        break;
+    }
+
+    // Reset clause runs to the end of the row
+    qsizetype reset = body.indexOf(u"Resets", 0, Qt::CaseInsensitive);
+    if (reset < 0) reset = body.indexOf(u"Reset ", 0, Qt::CaseInsensitive);
+    if (reset >= 0) {
+        QStringView clause = body.mid(reset);
+        // Drop a trailing panel border
+        while (!clause.isEmpty() && !clause.back().isLetterOrNumber() && clause.back() != u')')
+            clause.chop(1);
+        tokens.reset = clause.toString();
+    }
+
+    return tokens;
+}
+
+QList<UsageLimit> ClaudeUsageParser::limits() const {
+    struct Entry {
+        Section section;
+        int percent = -1;
+        QString reset;
+    };
+
+    // Attach percentages and reset clauses to the nearest section above them
+    QList<Entry> entries;
+    int current = -1;
+    for (auto it = m_rows.cbegin(); it != m_rows.cend(); ++it) {
+        const RowTokens &tokens = it.value();
+        if (tokens.section != Section::None) {
+            current = -1;
+            for (int i = 0; i < entries.size(); ++i) {
+                if (entries[i].section == tokens.section) current = i;
+            }
+            if (current < 0) {
+                entries.append({tokens.section});
+                current = entries.size() - 1;
+            }
+        }
+        if (current < 0) continue;
+        if (tokens.percent >= 0 && entries[current].percent < 0)
+            entries[current].percent = tokens.percent;
+        if (!tokens.reset.isEmpty() && entries[current].reset.isEmpty())
+            entries[current].reset = tokens.reset;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    QList<UsageLimit> result;
+    for (const Entry &entry : std::as_const(entries)) {
+        if (entry.percent < 0) continue;
+
+        UsageLimit limit;
+        switch (entry.section) {
+        case Section::Session:
+            limit.label = "Session";
+            break;
+        case Section::WeeklyAll:
+            limit.label = "Weekly (all)";
+            break;
+        case Section::WeeklySonnet:
+            limit.label = "Weekly (Sonnet)";
+            break;
+        case Section::Extra:
+            limit.label = "Extra";
+            break;
+        case Section::None:
+            break;
+        }
+        limit.used = entry.percent;
+        limit.total = 100.0;
+        if (!entry.reset.isEmpty())
+            limit.resetDescription = relativeResetDescription(entry.reset, now);
+        result.append(limit);
+    }
+    return result;
+}
+
+ClaudeUsageParser::Progress ClaudeUsageParser::progress() const {
+    // Same attribution as limits(): tokens belong to the nearest section above
+    Progress progress;
+    SectionState *current = nullptr;
+    for (auto it = m_rows.cbegin(); it != m_rows.cend(); ++it) {
+        const RowTokens &tokens = it.value();
+        if (tokens.section != Section::None) {
+            current = &progress.sections[static_cast<size_t>(tokens.section)];
+            current->seen = true;
+        }
+        if (!current) continue;
+        if (tokens.percent >= 0) current->percent = true;
+        if (!tokens.reset.isEmpty()) current->reset = true;
+        if (tokens.footer) progress.footer = true;
+    }
+    return progress;
+}
+
+bool ClaudeUsageParser::hasLimits() const {
+    for (const SectionState &state : progress().sections) {
+        if (state.percent) return true;
+    }
+    return false;
+}
+
+bool ClaudeUsageParser::isComplete() const {
+    const Progress current = progress();
+    const auto &sections = current.sections;
+    const SectionState &extra = sections[static_cast<size_t>(Section::Extra)];
+
+    if (!sections[static_cast<size_t>(Section::Session)].percent ||
+        !sections[static_cast<size_t>(Section::WeeklyAll)].percent)
+        return false;
+
+    // A section still missing its reset clause may be half drawn, until the
+    // footer below the last section shows the panel is finished: a limit
+    // with nothing used yet has no "Resets" line at all. Extra usage may
+    // show no percentage either ("not enabled").
+    for (const SectionState &state : sections) {
+        if (!state.seen || &state == &extra) continue;
+        if (!state.percent || (!state.reset && !current.footer)) return false;
+    }
+
+    return current.footer || (extra.percent && extra.reset);
+}
+
+QString ClaudeUsageParser::relativeResetDescription(QStringView clause, const QDateTime &now) {
+    QStringView text = clause.trimmed();
+
+    // Normalize prefix: "Resets 5pm" / "Reset 5pm"
+    if (text.startsWith(u"Resets", Qt::CaseInsensitive)) text = text.mid(6);
+    else if (text.startsWith(u"Reset", Qt::CaseInsensitive)) text = text.mid(5);
+    text = text.trimmed();
+
+    // Remove timezone like "(Europe/Bucharest)"
+    if (text.endsWith(u')')) {
+        qsizetype open = text.lastIndexOf(u'(');
+        if (open >= 0) text = text.left(open).trimmed();
+    }
+    const QString timeStr = text.toString().simplified();
+    if (timeStr.isEmpty()) return QString();
+
+    // Parse absolute time from Claude CLI into relative "Resets in Xh Ym"
+    // Formats: "5pm", "9:59am", "Apr 10, 9:59am", "Apr 10, 5pm"
+    QDateTime resetDt;
+    if (timeStr.at(0).isLetter()) {
+        // Has date component: "Apr 10, 9:59am"
+        QStringList parts = timeStr.split(u' ', Qt::SkipEmptyParts);
+        if (parts.size() >= 3) {
+            const QString monthDay = parts[0] + " " + parts[1].remove(u',');
+            const QString timePart = parts.mid(2).join(u' ');
+            const QString stamp = QString("%1 %2 %3").arg(now.date().year()).arg(monthDay, timePart);
+            // Try with minutes then without
+            resetDt = QDateTime::fromString(stamp, "yyyy MMM d h:mmap");
+            if (!resetDt.isValid())
+                resetDt = QDateTime::fromString(stamp, "yyyy MMM d hap");
+        }
+    } else {
+        // Time only: "5pm", "9:59am" — assume today
+        QTime t = QTime::fromString(timeStr, "h:mmap");
+        if (!t.isValid()) t = QTime::fromString(timeStr, "hap");
+        if (t.isValid()) resetDt = QDateTime(now.date(), t);
+    }
+
+    if (!resetDt.isValid()) return QString();
+
+    qint64 secsLeft = now.secsTo(resetDt);
+    if (secsLeft <= 0) return QString();
+
+    int days = secsLeft / 86400;
+    int hours = (secsLeft % 86400) / 3600;
+    int mins = (secsLeft % 3600) / 60;
+    if (days > 0)
+        return QString("Resets in %1d %2h").arg(days).arg(hours);
+    if (hours > 0)
+        return QString("Resets in %1h %2m").arg(hours).arg(mins);
+    return QString("Resets in %1m").arg(mins);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Provider.h"
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringView>
+#include <array>
+
+// Incremental parser for the Usage tab of claude's /status panel.
+// Each rendered screen row is tokenized once when it changes (section
+// header, "N% used", reset clause); limits are assembled from the
+// classified rows in screen order without rescanning any text.
+class ClaudeUsageParser {
+public:
+    void reset();
+
+    // Re-tokenize one screen row after it was redrawn
+    void updateRow(int row, QStringView text);
+
+    // Session and weekly limits are present, every section drawn so far has
+    // its percentage and reset clause, and the panel footer (or the last
+    // section) has been drawn. Once the footer is there a section may lack
+    // its reset clause. Works on the row tokens only.
+    bool isComplete() const;
+    bool hasLimits() const;
+    QList<UsageLimit> limits() const;
+
+    // "Resets Apr 10, 9:59am (Europe/Bucharest)" -> "Resets in 2d 4h"
+    static QString relativeResetDescription(QStringView clause, const QDateTime &now);
+
+private:
+    enum class Section {
+        None,
+        Session,
+        WeeklyAll,
+        WeeklySonnet,
+        Extra
+    };
+
+    struct RowTokens {
+        Section section = Section::None;
+        int percent = -1;
+        QString reset;
+        bool footer = false; // "Esc to cancel" hint below the last section
+    };
+
+    struct SectionState {
+        bool seen = false;
+        bool percent = false;
+        bool reset = false;
+    };
+
+    struct Progress {
+        std::array<SectionState, 5> sections; // Indexed by Section
+        bool footer = false;
+    };
+
+    static RowTokens tokenize(QStringView text);
+    Progress progress() const;
+
+    // Only rows that carry at least one token
+    QMap<int, RowTokens> m_rows;
+};
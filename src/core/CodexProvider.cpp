@@ -1,13 +1,21 @@
 #include "CodexProvider.h"
-#include <QJsonDocument>
+#include "BinaryLocator.h"
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QSettings>
+
+// Backoff bounds for restarting a persistent app-server that died
+static constexpr int kRestartMinDelayMs = 1000;
+static constexpr int kRestartMaxDelayMs = 5 * 60 * 1000;
 
 CodexProvider::CodexProvider(QObject *parent)
     : Provider(ProviderID::Codex, parent)
 {
+    m_restartTimer.setSingleShot(true);
+    // The restart waits for its turn like any other refresh
+    connect(&m_restartTimer, &QTimer::timeout, this, &CodexProvider::refreshRequested);
 }
 
 CodexProvider::~CodexProvider()
@@ -20,171 +28,176 @@ CodexProvider::~CodexProvider()
 
 void CodexProvider::refresh()
 {
+    if (m_internalState == State::Ready) {
+        if (keepServerAlive() && m_process && m_process->state() == QProcess::Running) {
+            // Server is already up and initialized: only re-read the limits
+            fetchLimits();
+            return;
+        }
+        // Persistence was switched off, or the server went away unnoticed
+        m_internalState = State::Finished;
+        if (m_process) m_process->terminate();
+    }
+
     if (m_internalState != State::Idle && m_internalState != State::Finished) {
         // Already running
+        emit refreshSkipped();
+        return;
+    }
+
+    m_restartTimer.stop();
+
+    const QString program = BinaryLocator::instance()->find("codex");
+    if (program.isEmpty()) {
+        setState(ProviderState::Error);
+        m_internalState = State::Idle;
+        emit refreshSkipped();
         return;
     }
 
     if (m_process) {
+        // The old server's exit must not be mistaken for the new one's
+        disconnect(m_process, nullptr, this, nullptr);
         m_process->deleteLater();
         m_process = nullptr;
+        m_rpc = nullptr; // Owned by the process
     }
 
     m_process = new QProcess(this);
+    m_rpc = new JsonRpcClient(m_process, m_process);
     connect(m_process, &QProcess::started, this, &CodexProvider::onProcessStarted);
-    connect(m_process, &QProcess::readyReadStandardOutput, this, &CodexProvider::onReadyReadStandardOutput);
     connect(m_process, &QProcess::finished, this, &CodexProvider::onProcessFinished);
     connect(m_process, &QProcess::errorOccurred, this, &CodexProvider::onProcessError);
+    connect(m_rpc, &JsonRpcClient::notificationReceived, this, &CodexProvider::handleNotification);
+    // The app-server streams many events we have no use for
+    m_rpc->subscribe("account/rateLimits/updated");
 
     m_internalState = State::Starting;
     setState(ProviderState::Active); 
     // We could set a Loading state if we had one, but Active is fine.
     
     // Command from macOS: codex -s read-only -a untrusted app-server
-    QString program = "codex";
     QStringList arguments;
     arguments << "-s" << "read-only" << "-a" << "untrusted" << "app-server";
-    
-    // TODO: Ideally resolve 'codex' path similar to macOS BinaryLocator
-    // For now rely on PATH.
-    
+
     m_process->start(program, arguments);
 }
 
 void CodexProvider::onProcessStarted()
 {
     m_internalState = State::Initializing;
-    
-    // Send initialize
-    // params: ["clientInfo": ["name": clientName, "version": clientVersion]]    qDebug() << "CodexProvider: Process started, sending initialize";
-    
+    qDebug() << "CodexProvider: Process started, sending initialize";
+
+    // params: ["clientInfo": ["name": clientName, "version": clientVersion]]
     QJsonObject clientInfo;
     clientInfo["name"] = "codexbar-linux";
     clientInfo["version"] = "2.0.0";
     
     QJsonObject params;
     params["clientInfo"] = clientInfo;
-    
-    m_initializeId = m_nextId++;
-    QJsonObject request;
-    request["id"] = m_initializeId;
-    request["method"] = "initialize";
-    request["params"] = params;
-    
-    sendPayload(request);
-}
 
-void CodexProvider::onReadyReadStandardOutput()
-{
-    if (!m_process) return;
-    m_buffer.append(m_process->readAllStandardOutput());
-    
-    while (true) {
-        int newlineIndex = m_buffer.indexOf('\n');
-        if (newlineIndex == -1) break;
-        
-        QByteArray line = m_buffer.left(newlineIndex);
-        m_buffer.remove(0, newlineIndex + 1);
-        
-        if (line.trimmed().isEmpty()) continue;
-        
-        QJsonParseError parseError;
-        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
-        if (parseError.error == QJsonParseError::NoError && doc.isObject()) {
-            handleMessage(doc.object());
-        } else {
-            qWarning() << "CodexProvider: Failed to parse JSON:" << line;
+    m_rpc->call("initialize", params, [this](const QJsonValue &, const JsonRpcError &error) {
+        if (error.isError()) {
+            failRefresh(error);
+            return;
         }
-    }
+        qDebug() << "CodexProvider: Initialized, fetching limits";
+        // Initialized. Now send "initialized" notification and then fetch limits.
+        m_rpc->notify("initialized");
+        fetchLimits();
+    });
 }
 
-void CodexProvider::handleMessage(const QJsonObject &message)
+void CodexProvider::handleNotification(const QString &method, const QJsonObject &params)
 {
-    if (message.contains("id")) {
-        int id = message["id"].toInt();
-        if (message.contains("result")) {
-            handleRpcResult(id, message["result"]);
-        } else if (message.contains("error")) {
-            QJsonObject err = message["error"].toObject();
-            qWarning() << "CodexProvider: RPC Error:" << err["message"].toString();
-            // TODO: Handle error state
-        }
-    } else {
-        // Notification or other message
-        // macOS ignores notifications usually: if message["id"] == nil ...
+    // Only a kept-alive server can push updates between refreshes
+    if (method == "account/rateLimits/updated" && params.contains("rateLimits")) {
+        qDebug() << "CodexProvider: Rate limits pushed by server";
+        applyRateLimits(params["rateLimits"].toObject());
     }
 }
 
-void CodexProvider::handleRpcResult(int id, const QJsonValue &result)
+void CodexProvider::fetchLimits()
 {
-    if (id == m_initializeId) {
-        qDebug() << "CodexProvider: Initialized, fetching limits";
-        // Initialized. Now send "initialized" notification and then fetch limits.
-        sendNotification("initialized");
-        
-        m_fetchLimitsId = m_nextId++;
-        QJsonObject request;
-        request["id"] = m_fetchLimitsId;
-        request["method"] = "account/rateLimits/read";
-        
-        sendPayload(request);
-        m_internalState = State::FetchingLimits;
-        
-    } else if (id == m_fetchLimitsId) {
-        // Parse rate limits
+    m_internalState = State::FetchingLimits;
+    m_rpc->call("account/rateLimits/read", QJsonObject(), [this](const QJsonValue &result, const JsonRpcError &error) {
+        if (error.isError()) {
+            failRefresh(error);
+            return;
+        }
+
         // Response structure: { rateLimits: { primary: {...}, secondary: {...}, credits: {...} } }
-        UsageSnapshot snapshot;
-        snapshot.timestamp = QDateTime::currentDateTime();
-        
-        QJsonObject root = result.toObject(); // "result" value passed in
-        QJsonObject rateLimits = root["rateLimits"].toObject();
-        
-        // Helper to parse window
-        auto parseWindow = [](const QString &label, const QJsonObject &win) -> UsageLimit {
-            UsageLimit limit;
-            limit.label = label;
-            if (win.isEmpty()) return limit;
-            
-            double usedPercent = win["usedPercent"].toDouble();
-            limit.used = usedPercent;
-            limit.total = 100.0; 
-            limit.unit = "%";
-            limit.resetDescription = win["resetDescription"].toString();
-            return limit;
-        };
-        
-        snapshot.limits.append(parseWindow("Session", rateLimits["primary"].toObject()));
-        snapshot.limits.append(parseWindow("Weekly", rateLimits["secondary"].toObject()));
-        
-        qDebug() << "CodexProvider: Fetched limits. Count:" << snapshot.limits.size();
-
-        setSnapshot(snapshot);
-        setState(ProviderState::Active);
-        
+        applyRateLimits(result.toObject()["rateLimits"].toObject());
+        m_restartDelayMs = 0;
+
+        if (keepServerAlive()) {
+            // Keep the app-server for the next refresh and for pushed updates
+            m_internalState = State::Ready;
+            return;
+        }
+
         m_internalState = State::Finished;
-        
+
         // Done for this refresh cycle
         m_process->terminate();
-    }
+    });
 }
 
-void CodexProvider::sendPayload(const QJsonObject &payload)
+void CodexProvider::failRefresh(const JsonRpcError &error)
 {
-    if (!m_process) return;
-    QJsonDocument doc(payload);
-    QByteArray data = doc.toJson(QJsonDocument::Compact);
-    m_process->write(data);
-    m_process->write("\n");
+    // A dead server is already handled by onProcessFinished/onProcessError
+    if (error.code == JsonRpcError::Disconnected) return;
+
+    qWarning() << "CodexProvider: RPC Error:" << error.message;
+    setState(ProviderState::Error);
+
+    // Whatever the server is doing, start over with a fresh one
+    m_internalState = State::Finished;
+    if (m_process) m_process->terminate();
+    scheduleRestart();
 }
 
-void CodexProvider::sendNotification(const QString &method, const QJsonObject &params)
+void CodexProvider::applyRateLimits(const QJsonObject &rateLimits)
 {
-    QJsonObject p;
-    p["method"] = method;
-    if (!params.isEmpty()) {
-        p["params"] = params;
-    }
-    sendPayload(p);
+    UsageSnapshot snapshot;
+    snapshot.timestamp = QDateTime::currentDateTime();
+
+    // Helper to parse window
+    auto parseWindow = [](const QString &label, const QJsonObject &win) -> UsageLimit {
+        UsageLimit limit;
+        limit.label = label;
+        if (win.isEmpty()) return limit;
+
+        double usedPercent = win["usedPercent"].toDouble();
+        limit.used = usedPercent;
+        limit.total = 100.0;
+        limit.unit = "%";
+        limit.resetDescription = win["resetDescription"].toString();
+        return limit;
+    };
+
+    snapshot.limits.append(parseWindow("Session", rateLimits["primary"].toObject()));
+    snapshot.limits.append(parseWindow("Weekly", rateLimits["secondary"].toObject()));
+
+    qDebug() << "CodexProvider: Fetched limits. Count:" << snapshot.limits.size();
+
+    setSnapshot(snapshot);
+    setState(ProviderState::Active);
+}
+
+bool CodexProvider::keepServerAlive() const
+{
+    return QSettings("KDECodexBar", "KDECodexBar").value("codex_keep_server", false).toBool();
+}
+
+void CodexProvider::scheduleRestart()
+{
+    if (!keepServerAlive()) return;
+
+    m_restartDelayMs = m_restartDelayMs == 0 ? kRestartMinDelayMs
+                                             : qMin(m_restartDelayMs * 2, kRestartMaxDelayMs);
+    qDebug() << "CodexProvider: app-server died, restarting in" << m_restartDelayMs << "ms";
+    m_restartTimer.start(m_restartDelayMs);
 }
 
 void CodexProvider::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
@@ -194,11 +207,15 @@ void CodexProvider::onProcessFinished(int exitCode, QProcess::ExitStatus exitSta
     if (m_internalState == State::Finished) return;
 
     m_internalState = State::Finished;
+    m_rpc->failAll("app-server exited");
     if (exitStatus == QProcess::CrashExit) {
          qWarning() << "CodexProvider: Process crashed";
          setState(ProviderState::Error);
     }
     // else normal exit
+
+    // A persistent server is not supposed to exit on its own
+    scheduleRestart();
 }
 
 void CodexProvider::onProcessError(QProcess::ProcessError error)
@@ -209,4 +226,8 @@ void CodexProvider::onProcessError(QProcess::ProcessError error)
     qWarning() << "CodexProvider: Process error" << error;
     setState(ProviderState::Error);
     m_internalState = State::Idle;
+    m_rpc->failAll("app-server error");
+
+    // Crashes are followed by finished(), which schedules the restart itself
+    if (error != QProcess::Crashed) scheduleRestart();
 }
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "Provider.h"
+#include "JsonRpcClient.h"
 #include <QProcess>
 #include <QVariant>
 #include <QJsonObject>
+#include <QTimer>
 
 class CodexProvider : public Provider {
     Q_OBJECT
@@ -12,23 +14,23 @@ public:
     ~CodexProvider() override;
 
     void refresh() override;
+    bool spawnsProcess() const override { return true; }
 
 private slots:
     void onProcessStarted();
-    void onReadyReadStandardOutput();
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void onProcessError(QProcess::ProcessError error);
 
 private:
-    void sendRequest(const QString &method, const QJsonObject &params = QJsonObject());
-    void sendNotification(const QString &method, const QJsonObject &params = QJsonObject());
-    void sendPayload(const QJsonObject &payload);
-    void handleMessage(const QJsonObject &message);
-    void handleRpcResult(int id, const QJsonValue &result);
+    void handleNotification(const QString &method, const QJsonObject &params);
+    void fetchLimits();
+    void applyRateLimits(const QJsonObject &rateLimits);
+    void failRefresh(const JsonRpcError &error);
+    bool keepServerAlive() const;
+    void scheduleRestart();
 
     QProcess *m_process = nullptr;
-    int m_nextId = 1;
-    QByteArray m_buffer;
+    JsonRpcClient *m_rpc = nullptr;
     
     // State tracking for the simple sequential flow
     enum class State {
@@ -36,10 +38,12 @@ private:
         Starting,
         Initializing,
         FetchingLimits,
+        Ready,     // Persistent mode: initialized and idle between refreshes
         Finished
     };
     State m_internalState = State::Idle;
-    
-    int m_initializeId = -1;
-    int m_fetchLimitsId = -1;
+
+    // Persistent mode: restart a dead app-server with exponential backoff
+    QTimer m_restartTimer;
+    int m_restartDelayMs = 0;
 };
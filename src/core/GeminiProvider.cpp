@@ -1,11 +1,11 @@
 #include "GeminiProvider.h"
-#include <QNetworkReply>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
-#include <QStandardPaths>
+#include <QSaveFile>
 #include <QDebug>
 
 // Extracted from Gemini CLI bundle
@@ -14,32 +14,85 @@ static const QString kClientSecret = "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";
 static const QString kQuotaEndpoint = "https://cloudcode-pa.googleapis.com/v1internal:retrieveUserQuota";
 static const QString kTokenEndpoint = "https://oauth2.googleapis.com/token";
 
+static constexpr int kRequestTimeoutMs = 15000;
+
+// Background refresh starts this long before the token expires
+static constexpr qint64 kRefreshAheadMs = 5 * 60 * 1000;
+// Retry delay after a failed background refresh
+static constexpr int kRefreshRetryMs = 60 * 1000;
+
 GeminiProvider::GeminiProvider(QObject *parent)
     : Provider(ProviderID::Gemini, parent)
-    , m_nam(new QNetworkAccessManager(this))
 {
+    m_tokenRefreshTimer.setSingleShot(true);
+    connect(&m_tokenRefreshTimer, &QTimer::timeout, this, &GeminiProvider::refreshAccessToken);
+
+    connect(&m_credsWatcher, &QFileSystemWatcher::fileChanged, this, &GeminiProvider::onCredentialsChanged);
+    connect(&m_credsWatcher, &QFileSystemWatcher::directoryChanged, this, &GeminiProvider::onCredentialsChanged);
+    watchCredentials();
+
+    if (loadCredentials()) scheduleTokenRefresh();
 }
 
 GeminiProvider::~GeminiProvider() = default;
 
+QString GeminiProvider::credentialsPath() {
+    return QDir::homePath() + "/.gemini/oauth_creds.json";
+}
+
 void GeminiProvider::refresh() {
-    if (!loadCredentials()) {
+    // Previous poll still running
+    if ((m_quotaCall && !m_quotaCall->isFinished()) || m_quotaAfterRefresh) {
+        emit refreshSkipped();
+        return;
+    }
+
+    if (!m_credsLoaded && !loadCredentials()) {
         setState(ProviderState::Error);
+        emit refreshSkipped();
         return;
     }
 
+    // Normally the timer has renewed the token already; this only catches
+    // timers that could not fire in time (suspend, failed refresh)
     qint64 now = QDateTime::currentMSecsSinceEpoch();
-    // Refresh if expired or expiring soon (within 5 minutes)
-    if (m_creds.expiryDateMs > 0 && now > (m_creds.expiryDateMs - 300000)) {
+    if (m_creds.expiryDateMs > 0 && now > m_creds.expiryDateMs - 60000) {
+        m_quotaAfterRefresh = true;
         refreshAccessToken();
     } else {
         fetchQuota();
     }
 }
 
+void GeminiProvider::watchCredentials() {
+    // The directory catches the file being created or replaced by rename,
+    // which silently ends a watch on the file itself
+    const QString path = credentialsPath();
+    const QString dir = QFileInfo(path).absolutePath();
+    if (QFileInfo(dir).isDir() && !m_credsWatcher.directories().contains(dir)) {
+        m_credsWatcher.addPath(dir);
+    }
+    if (QFileInfo::exists(path) && !m_credsWatcher.files().contains(path)) {
+        m_credsWatcher.addPath(path);
+    }
+}
+
+void GeminiProvider::onCredentialsChanged() {
+    watchCredentials();
+
+    const QByteArray previous = QJsonDocument(m_credsJson).toJson(QJsonDocument::Compact);
+    m_credsLoaded = false;
+    if (!loadCredentials()) return;
+
+    // Directory events also fire for unrelated files, and for our own writes
+    if (QJsonDocument(m_credsJson).toJson(QJsonDocument::Compact) == previous) return;
+
+    qDebug() << "GeminiProvider: Credentials changed on disk";
+    scheduleTokenRefresh();
+}
+
 bool GeminiProvider::loadCredentials() {
-    QString home = QDir::homePath();
-    QFile file(home + "/.gemini/oauth_creds.json");
+    QFile file(credentialsPath());
     if (!file.open(QIODevice::ReadOnly)) {
         qDebug() << "GeminiProvider: Could not open credentials file.";
         return false;
@@ -49,45 +102,62 @@ bool GeminiProvider::loadCredentials() {
     QJsonDocument doc = QJsonDocument::fromJson(data);
     QJsonObject root = doc.object();
 
+    m_credsJson = root;
     m_creds.accessToken = root.value("access_token").toString();
     m_creds.refreshToken = root.value("refresh_token").toString();
     m_creds.expiryDateMs = static_cast<qint64>(root.value("expiry_date").toDouble());
 
-    return !m_creds.accessToken.isEmpty();
+    m_credsLoaded = !m_creds.accessToken.isEmpty();
+    return m_credsLoaded;
 }
 
-void GeminiProvider::saveCredentials(const QJsonObject &json) {
-    QString home = QDir::homePath();
-    QFile file(home + "/.gemini/oauth_creds.json");
-    if (!file.open(QIODevice::ReadOnly)) {
-        return; // Handle error?
+void GeminiProvider::scheduleTokenRefresh() {
+    if (m_creds.refreshToken.isEmpty() || m_creds.expiryDateMs <= 0) {
+        m_tokenRefreshTimer.stop();
+        return;
     }
-    
-    // Read existing to preserve other fields like id_token if needed
-    QByteArray data = file.readAll();
-    file.close();
-    
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonObject root = doc.object();
-    
+
+    const qint64 delay = m_creds.expiryDateMs - kRefreshAheadMs - QDateTime::currentMSecsSinceEpoch();
+    m_tokenRefreshTimer.start(static_cast<int>(qBound<qint64>(0, delay, 24 * 3600 * 1000)));
+}
+
+void GeminiProvider::saveCredentials(const QJsonObject &json) {
+    // Start from the cached file contents to preserve fields like id_token
+    QJsonObject root = m_credsJson;
+
     // Update fields
     if (json.contains("access_token")) root["access_token"] = json["access_token"];
+    if (json.contains("refresh_token")) root["refresh_token"] = json["refresh_token"];
     if (json.contains("expires_in")) {
         double expiresIn = json["expires_in"].toDouble();
         root["expiry_date"] = static_cast<double>(QDateTime::currentMSecsSinceEpoch() + (expiresIn * 1000));
-        m_creds.expiryDateMs = static_cast<qint64>(root["expiry_date"].toDouble());
     }
-    
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(QJsonDocument(root).toJson());
-    }
-    
+
     // Update local cache
-    if (json.contains("access_token")) m_creds.accessToken = json["access_token"].toString();
+    m_credsJson = root;
+    m_creds.accessToken = root.value("access_token").toString();
+    m_creds.refreshToken = root.value("refresh_token").toString();
+    m_creds.expiryDateMs = static_cast<qint64>(root.value("expiry_date").toDouble());
+
+    // Atomic replace, so the Gemini CLI never reads a half-written file
+    QSaveFile file(credentialsPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "GeminiProvider: Could not write credentials file.";
+        return;
+    }
+    file.write(QJsonDocument(root).toJson());
+    if (!file.commit()) {
+        qDebug() << "GeminiProvider: Could not write credentials file.";
+    }
 }
 
 void GeminiProvider::refreshAccessToken() {
     if (m_isRefreshing) return;
+    if (m_creds.refreshToken.isEmpty()) {
+        if (m_quotaAfterRefresh) setState(ProviderState::Error);
+        m_quotaAfterRefresh = false;
+        return;
+    }
     m_isRefreshing = true;
     
     QUrl url(kTokenEndpoint);
@@ -100,27 +170,34 @@ void GeminiProvider::refreshAccessToken() {
     body.append("&refresh_token=" + m_creds.refreshToken.toUtf8());
     body.append("&grant_type=refresh_token");
     
-    QNetworkReply *reply = m_nam->post(request, body);
-    connect(reply, &QNetworkReply::finished, this, [this, reply](){
-        onTokenRefreshReply(reply);
-    });
+    // Renewing twice is harmless, so connection failures are retried
+    HttpOptions options;
+    options.timeoutMs = kRequestTimeoutMs;
+    options.idempotent = true;
+    HttpClient::instance()->post(request, body, this, [this](const HttpResponse &response) {
+        onTokenRefreshReply(response);
+    }, options);
 }
 
-void GeminiProvider::onTokenRefreshReply(QNetworkReply *reply) {
+void GeminiProvider::onTokenRefreshReply(const HttpResponse &response) {
     m_isRefreshing = false;
-    reply->deleteLater();
-    
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "GeminiProvider: Token refresh failed:" << reply->errorString();
-        setState(ProviderState::Error);
+
+    const bool quotaWaiting = m_quotaAfterRefresh;
+    m_quotaAfterRefresh = false;
+
+    if (!response.ok()) {
+        qDebug() << "GeminiProvider: Token refresh failed:" << response.errorString;
+        m_tokenRefreshTimer.start(kRefreshRetryMs);
+        if (quotaWaiting) setState(ProviderState::Error);
         return;
     }
     
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(response.body);
     saveCredentials(doc.object());
-    
+    scheduleTokenRefresh();
+
     // Retry fetch
-    fetchQuota();
+    if (quotaWaiting) fetchQuota();
 }
 
 void GeminiProvider::fetchQuota() {
@@ -132,24 +209,28 @@ void GeminiProvider::fetchQuota() {
     // Empty JSON body usually works, but we could add project ID if we wanted to be strict
     QByteArray body = "{}";
     
-    QNetworkReply *reply = m_nam->post(request, body);
-    connect(reply, &QNetworkReply::finished, this, [this, reply](){ onQuotaReply(reply); });
+    // Read-only, so it may be retried and hedged
+    HttpOptions options;
+    options.timeoutMs = kRequestTimeoutMs;
+    options.idempotent = true;
+    options.hedge = true;
+    m_quotaCall = HttpClient::instance()->post(request, body, this, [this](const HttpResponse &response) {
+        onQuotaReply(response);
+    }, options);
 }
 
-void GeminiProvider::onQuotaReply(QNetworkReply *reply) {
-    reply->deleteLater();
-    
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "GeminiProvider: Quota fetch failed:" << reply->errorString();
-        // If 401, maybe force refresh next time?
-        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 401) {
-             m_creds.expiryDateMs = 0; // Force refresh
+void GeminiProvider::onQuotaReply(const HttpResponse &response) {
+    if (!response.ok()) {
+        qDebug() << "GeminiProvider: Quota fetch failed:" << response.errorString;
+        if (response.status == 401) {
+             // Token was revoked or expired early, renew it now
+             m_tokenRefreshTimer.start(0);
         }
         setState(ProviderState::Error);
         return;
     }
     
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonDocument doc = QJsonDocument::fromJson(response.body);
     QJsonObject root = doc.object();
     QJsonArray buckets = root.value("buckets").toArray();
     
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "Provider.h"
-#include <QNetworkAccessManager>
+#include "HttpClient.h"
 #include <QPointer>
 #include <QDateTime>
+#include <QFileSystemWatcher>
 #include <QJsonObject>
+#include <QTimer>
 
 class GeminiProvider : public Provider {
     Q_OBJECT
@@ -15,8 +17,7 @@ public:
     void refresh() override;
 
 private slots:
-    void onQuotaReply(QNetworkReply *reply);
-    void onTokenRefreshReply(QNetworkReply *reply);
+    void onCredentialsChanged();
 
 private:
     struct OAuthCredentials {
@@ -25,12 +26,25 @@ private:
         qint64 expiryDateMs = 0; // Epoch ms
     };
 
+    static QString credentialsPath();
+
     void fetchQuota();
+    void onQuotaReply(const HttpResponse &response);
+    void onTokenRefreshReply(const HttpResponse &response);
     bool loadCredentials();
+    void watchCredentials();
+    void scheduleTokenRefresh();
     void refreshAccessToken();
     void saveCredentials(const QJsonObject &json);
 
-    QNetworkAccessManager *m_nam;
+    QPointer<HttpCall> m_quotaCall;
+    // Parsed once and kept until the Gemini CLI rewrites the file
     OAuthCredentials m_creds;
+    QJsonObject m_credsJson;
+    bool m_credsLoaded = false;
+    QFileSystemWatcher m_credsWatcher;
+    // Fires ahead of expiry so polls find a valid token
+    QTimer m_tokenRefreshTimer;
     bool m_isRefreshing = false;
+    bool m_quotaAfterRefresh = false;
 };
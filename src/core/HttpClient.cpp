@@ -0,0 +1,296 @@
+#include "HttpClient.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QNetworkAccessManager>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QSslConfiguration>
+#include <QStandardPaths>
+#include <utility>
+
+// Retry backoff: 250ms, 500ms, 1s... each scaled by a random 50-100%
+static constexpr int kRetryBaseDelayMs = 250;
+static constexpr int kRetryMaxDelayMs = 5000;
+// Hedging needs some history before the percentile means anything
+static constexpr int kHedgeMinSamples = 10;
+// New tickets tend to arrive in bursts, one per connection
+static constexpr int kTlsSaveDelayMs = 2000;
+
+HttpCall::HttpCall(HttpClient *client, const QByteArray &verb, const QNetworkRequest &request,
+                   const QByteArray &body, const HttpOptions &options, QObject *context, Callback callback)
+    : QObject(client)
+    , m_client(client)
+    , m_verb(verb)
+    , m_request(request)
+    , m_body(body)
+    , m_options(options)
+    , m_callback(std::move(callback))
+{
+    m_deadlineTimer.setSingleShot(true);
+    connect(&m_deadlineTimer, &QTimer::timeout, this, &HttpCall::onDeadline);
+    m_hedgeTimer.setSingleShot(true);
+    connect(&m_hedgeTimer, &QTimer::timeout, this, &HttpCall::sendHedge);
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &HttpCall::sendAttempt);
+
+    if (context) {
+        // Nobody is left to call back; just stop the network traffic
+        connect(context, &QObject::destroyed, this, [this]() {
+            m_callback = nullptr;
+            cancel();
+        });
+    }
+}
+
+void HttpCall::cancel() {
+    if (m_finished) return;
+    HttpResponse response;
+    response.error = QNetworkReply::OperationCanceledError;
+    response.errorString = "cancelled";
+    response.cancelled = true;
+    response.attempts = m_attempt;
+    finish(response);
+}
+
+void HttpCall::sendAttempt() {
+    m_attempt++;
+    m_attemptTimedOut = false;
+    m_attemptTimer.start();
+    m_replies.append(send());
+    m_deadlineTimer.start(m_options.timeoutMs);
+
+    if (m_options.hedge && m_options.idempotent && m_attempt == 1) {
+        const LatencyHistogram &history = m_client->latency(m_request.url());
+        if (history.count() >= kHedgeMinSamples) {
+            m_hedgeTimer.start(static_cast<int>(history.percentile(m_options.hedgePercentile)));
+        }
+    }
+}
+
+QNetworkReply *HttpCall::send() {
+    // Attach the newest ticket, a retry may find one the first try did not
+    QNetworkRequest request(m_request);
+    m_client->prepareTls(request);
+
+    QElapsedTimer sent;
+    sent.start();
+    QNetworkReply *reply = m_client->m_nam->sendCustomRequest(request, m_verb, m_body);
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() { onReplyFinished(reply); });
+    // Only emitted when a new connection was set up, not for pooled ones
+    connect(reply, &QNetworkReply::encrypted, this, [this, sent]() {
+        m_client->recordConnectionSetup(m_request.url(), sent.elapsed());
+    });
+    return reply;
+}
+
+void HttpCall::sendHedge() {
+    if (m_finished || m_replies.size() != 1) return;
+    qDebug() << "HttpClient: hedging slow request to" << m_request.url().toDisplayString();
+    m_replies.append(send());
+}
+
+void HttpCall::onReplyFinished(QNetworkReply *reply) {
+    if (m_finished) return;
+    m_replies.removeOne(reply);
+    reply->deleteLater();
+    m_client->storeTlsSession(reply);
+
+    HttpResponse response;
+    response.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    response.error = reply->error();
+    response.errorString = reply->errorString();
+    response.body = reply->readAll();
+    response.timedOut = m_attemptTimedOut;
+    response.attempts = m_attempt;
+
+    if (response.ok()) {
+        m_client->latency(m_request.url()).record(m_attemptTimer.elapsed());
+        finish(response);
+        return;
+    }
+
+    // The hedged twin may still succeed
+    if (!m_replies.isEmpty()) return;
+
+    if (m_options.idempotent && m_attempt < m_options.maxAttempts && isRetryable(response)) {
+        m_deadlineTimer.stop();
+        m_hedgeTimer.stop();
+        const int backoff = qMin(kRetryBaseDelayMs << (m_attempt - 1), kRetryMaxDelayMs);
+        const int delay = backoff / 2 + QRandomGenerator::global()->bounded(backoff / 2 + 1);
+        qDebug() << "HttpClient:" << m_request.url().toDisplayString() << "failed:"
+                 << response.errorString << "- retrying in" << delay << "ms";
+        m_retryTimer.start(delay);
+        return;
+    }
+
+    finish(response);
+}
+
+void HttpCall::onDeadline() {
+    if (m_finished) return;
+    m_attemptTimedOut = true;
+    // Aborting finishes the replies with OperationCanceledError
+    const QList<QNetworkReply *> replies = m_replies;
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+    }
+}
+
+bool HttpCall::isRetryable(const HttpResponse &response) {
+    if (response.timedOut) return true;
+    switch (response.status) {
+    case 429:
+    case 502:
+    case 503:
+    case 504:
+        return true;
+    default:
+        break;
+    }
+    switch (response.error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void HttpCall::finish(const HttpResponse &response) {
+    m_finished = true;
+    m_deadlineTimer.stop();
+    m_hedgeTimer.stop();
+    m_retryTimer.stop();
+    dropReplies();
+
+    // Moved out first: the callback may start a new call or cancel this one
+    Callback callback = std::move(m_callback);
+    m_callback = nullptr;
+    if (callback) callback(response);
+    deleteLater();
+}
+
+void HttpCall::dropReplies() {
+    const QList<QNetworkReply *> replies = std::exchange(m_replies, {});
+    for (QNetworkReply *reply : replies) {
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+HttpClient *HttpClient::instance() {
+    static HttpClient *client = nullptr;
+    if (!client) {
+        client = new HttpClient(QCoreApplication::instance());
+    }
+    return client;
+}
+
+HttpClient::HttpClient(QObject *parent)
+    : QObject(parent)
+    , m_nam(new QNetworkAccessManager(this))
+    , m_tlsSessions(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tls-sessions")
+{
+    // Replies are owned and freed by their HttpCall
+    m_nam->setAutoDeleteReplies(false);
+
+    m_tlsSaveTimer.setSingleShot(true);
+    connect(&m_tlsSaveTimer, &QTimer::timeout, this, &HttpClient::saveTlsSessions);
+    if (persistTlsSessions()) {
+        m_tlsSessions.load();
+    }
+}
+
+HttpCall *HttpClient::get(const QNetworkRequest &request, QObject *context, HttpCall::Callback callback,
+                          const HttpOptions &options) {
+    return start("GET", request, QByteArray(), context, std::move(callback), options);
+}
+
+HttpCall *HttpClient::post(const QNetworkRequest &request, const QByteArray &body, QObject *context,
+                           HttpCall::Callback callback, const HttpOptions &options) {
+    return start("POST", request, body, context, std::move(callback), options);
+}
+
+HttpCall *HttpClient::start(const QByteArray &verb, const QNetworkRequest &request, const QByteArray &body,
+                            QObject *context, HttpCall::Callback callback, const HttpOptions &options) {
+    QNetworkRequest pooled(request);
+    // Multiplex over one connection where the server allows it; HTTP/1.1
+    // connections stay in the manager's keep-alive pool either way
+    pooled.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    auto *call = new HttpCall(this, verb, pooled, body, options, context, std::move(callback));
+    call->sendAttempt();
+    return call;
+}
+
+QString HttpClient::endpointKey(const QUrl &url) {
+    return url.adjusted(QUrl::RemoveQuery | QUrl::RemoveFragment | QUrl::RemoveUserInfo).toString();
+}
+
+LatencyHistogram &HttpClient::latency(const QUrl &url) {
+    const QString key = endpointKey(url);
+    auto it = m_latencies.find(key);
+    if (it == m_latencies.end()) {
+        it = m_latencies.insert(key, LatencyHistogram("http " + key));
+    }
+    return it.value();
+}
+
+QString HttpClient::hostPort(const QUrl &url) {
+    return QString("%1:%2").arg(url.host()).arg(url.port(url.scheme() == "https" ? 443 : 80));
+}
+
+void HttpClient::prepareTls(QNetworkRequest &request) const {
+    if (request.url().scheme() != "https") return;
+
+    // Keeps the caller's settings (e.g. VerifyNone for local servers)
+    QSslConfiguration config = request.sslConfiguration();
+    config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    const QByteArray ticket = m_tlsSessions.ticket(hostPort(request.url()));
+    if (!ticket.isEmpty()) {
+        config.setSessionTicket(ticket);
+    }
+    request.setSslConfiguration(config);
+}
+
+void HttpClient::storeTlsSession(QNetworkReply *reply) {
+    if (reply->url().scheme() != "https") return;
+
+    const QSslConfiguration config = reply->sslConfiguration();
+    if (m_tlsSessions.store(hostPort(reply->url()), config.sessionTicket(), config.sessionTicketLifeTimeHint())) {
+        m_tlsSaveTimer.start(kTlsSaveDelayMs);
+    }
+}
+
+void HttpClient::recordConnectionSetup(const QUrl &url, qint64 ms) {
+    const QString key = hostPort(url);
+    auto it = m_connectionSetup.find(key);
+    if (it == m_connectionSetup.end()) {
+        it = m_connectionSetup.insert(key, LatencyHistogram("tls " + key));
+    }
+    it->record(ms);
+    qDebug() << "HttpClient:" << it->summary();
+}
+
+QString HttpClient::connectionSetupSummary(const QUrl &url) const {
+    return m_connectionSetup.value(hostPort(url)).summary();
+}
+
+void HttpClient::saveTlsSessions() {
+    // Checked on every save, so switching the setting off takes effect
+    // without a restart
+    if (persistTlsSessions()) {
+        m_tlsSessions.save();
+    } else {
+        m_tlsSessions.removeFile();
+    }
+}
+
+bool HttpClient::persistTlsSessions() {
+    return QSettings("KDECodexBar", "KDECodexBar").value("tls_session_cache", false).toBool();
+}
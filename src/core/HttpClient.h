@@ -0,0 +1,129 @@
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "TlsSessionCache.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QTimer>
+#include <functional>
+
+class QNetworkAccessManager;
+
+struct HttpResponse {
+    int status = 0; // HTTP status, 0 when no response arrived
+    QNetworkReply::NetworkError error = QNetworkReply::NoError;
+    QString errorString;
+    QByteArray body;
+    bool timedOut = false;
+    bool cancelled = false;
+    int attempts = 0;
+
+    bool ok() const { return error == QNetworkReply::NoError; }
+};
+
+struct HttpOptions {
+    // Deadline for each attempt, from sending until the body is complete
+    int timeoutMs = 10000;
+    // Only idempotent calls are retried or hedged
+    bool idempotent = false;
+    int maxAttempts = 3;
+    // Send a second copy when the first is slower than this percentile of
+    // the endpoint's recorded latencies; the first to finish wins
+    bool hedge = false;
+    double hedgePercentile = 95.0;
+};
+
+class HttpClient;
+
+// Handle for one logical request, possibly spanning retries and a hedged
+// duplicate. The callback runs exactly once — with a result, an error, a
+// timeout or a cancellation — unless the context object died first. The
+// handle deletes itself afterwards; hold it in a QPointer.
+class HttpCall : public QObject {
+    Q_OBJECT
+public:
+    using Callback = std::function<void(const HttpResponse &response)>;
+
+    void cancel();
+    bool isFinished() const { return m_finished; }
+
+private:
+    friend class HttpClient;
+
+    HttpCall(HttpClient *client, const QByteArray &verb, const QNetworkRequest &request,
+             const QByteArray &body, const HttpOptions &options, QObject *context, Callback callback);
+
+    void sendAttempt();
+    QNetworkReply *send();
+    void sendHedge();
+    void onReplyFinished(QNetworkReply *reply);
+    void onDeadline();
+    void finish(const HttpResponse &response);
+    void dropReplies();
+    static bool isRetryable(const HttpResponse &response);
+
+    HttpClient *m_client;
+    QByteArray m_verb;
+    QNetworkRequest m_request;
+    QByteArray m_body;
+    HttpOptions m_options;
+    Callback m_callback;
+
+    QList<QNetworkReply *> m_replies;
+    int m_attempt = 0;
+    bool m_attemptTimedOut = false;
+    bool m_finished = false;
+    QElapsedTimer m_attemptTimer;
+    QTimer m_deadlineTimer;
+    QTimer m_hedgeTimer;
+    QTimer m_retryTimer;
+};
+
+// Shared HTTP client: one QNetworkAccessManager for every provider, so
+// TLS sessions and HTTP/2 connections are pooled across refreshes.
+class HttpClient : public QObject {
+    Q_OBJECT
+public:
+    static HttpClient *instance();
+
+    HttpCall *get(const QNetworkRequest &request, QObject *context, HttpCall::Callback callback,
+                  const HttpOptions &options = HttpOptions());
+    HttpCall *post(const QNetworkRequest &request, const QByteArray &body, QObject *context,
+                   HttpCall::Callback callback, const HttpOptions &options = HttpOptions());
+
+    QNetworkAccessManager *networkAccessManager() const { return m_nam; }
+
+    // Time from sending until the TLS handshake of a new connection was
+    // done, per host:port; resumed sessions should show up as a drop
+    QString connectionSetupSummary(const QUrl &url) const;
+
+private:
+    friend class HttpCall;
+
+    explicit HttpClient(QObject *parent = nullptr);
+
+    HttpCall *start(const QByteArray &verb, const QNetworkRequest &request, const QByteArray &body,
+                    QObject *context, HttpCall::Callback callback, const HttpOptions &options);
+
+    // Latencies per scheme://host:port/path, feeding the hedge delay
+    static QString endpointKey(const QUrl &url);
+    LatencyHistogram &latency(const QUrl &url);
+
+    static QString hostPort(const QUrl &url);
+    void prepareTls(QNetworkRequest &request) const;
+    void storeTlsSession(QNetworkReply *reply);
+    void recordConnectionSetup(const QUrl &url, qint64 ms);
+    void saveTlsSessions();
+    static bool persistTlsSessions();
+
+    QNetworkAccessManager *m_nam;
+    QHash<QString, LatencyHistogram> m_latencies;
+    QHash<QString, LatencyHistogram> m_connectionSetup;
+    TlsSessionCache m_tlsSessions;
+    QTimer m_tlsSaveTimer;
+};
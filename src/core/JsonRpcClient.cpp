@@ -0,0 +1,192 @@
+#include "JsonRpcClient.h"
+#include <QDebug>
+#include <QIODevice>
+#include <QJsonDocument>
+#include <limits>
+
+// Consumed bytes are only dropped from the front of the buffer once they
+// outweigh the unread tail, so shifting stays linear in the input size
+static constexpr qsizetype kCompactThreshold = 64 * 1024;
+
+JsonRpcClient::JsonRpcClient(QIODevice *device, QObject *parent)
+    : QObject(parent)
+    , m_device(device)
+{
+    m_deadlineTimer.setSingleShot(true);
+    connect(&m_deadlineTimer, &QTimer::timeout, this, &JsonRpcClient::onDeadlineExpired);
+    connect(m_device, &QIODevice::readyRead, this, &JsonRpcClient::onReadyRead);
+}
+
+// Pending callbacks are dropped without being invoked: their owner is
+// usually being destroyed as well
+JsonRpcClient::~JsonRpcClient() = default;
+
+int JsonRpcClient::call(const QString &method, const QJsonObject &params, Callback callback, int timeoutMs) {
+    const int id = m_nextId++;
+    m_pending.insert(id, {method, std::move(callback), QDeadlineTimer(timeoutMs)});
+
+    QJsonObject request;
+    request["id"] = id;
+    request["method"] = method;
+    if (!params.isEmpty()) {
+        request["params"] = params;
+    }
+    send(request);
+    armDeadlineTimer();
+    return id;
+}
+
+void JsonRpcClient::notify(const QString &method, const QJsonObject &params) {
+    QJsonObject notification;
+    notification["method"] = method;
+    if (!params.isEmpty()) {
+        notification["params"] = params;
+    }
+    send(notification);
+}
+
+void JsonRpcClient::subscribe(const QString &method) {
+    const QByteArray needle = '"' + method.toUtf8() + '"';
+    if (!m_subscriptions.contains(needle)) m_subscriptions.append(needle);
+}
+
+void JsonRpcClient::cancel(int id) {
+    complete(id, QJsonValue(), {JsonRpcError::Cancelled, "cancelled"});
+}
+
+void JsonRpcClient::failAll(const QString &reason) {
+    const QList<int> ids = m_pending.keys();
+    for (int id : ids) {
+        complete(id, QJsonValue(), {JsonRpcError::Disconnected, reason});
+    }
+}
+
+int JsonRpcClient::pendingCount() const {
+    return m_pending.size();
+}
+
+void JsonRpcClient::send(const QJsonObject &payload) {
+    if (!m_device || !m_device->isWritable()) return;
+    QByteArray data = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    data.append('\n');
+    m_device->write(data);
+}
+
+void JsonRpcClient::onReadyRead() {
+    m_buffer.append(m_device->readAll());
+
+    while (true) {
+        const qsizetype newlineIndex = m_buffer.indexOf('\n', m_scanPos);
+        if (newlineIndex == -1) {
+            m_scanPos = m_buffer.size();
+            break;
+        }
+
+        // View into the buffer, nothing is copied until a parse needs it
+        const QByteArrayView line(m_buffer.constData() + m_readPos, newlineIndex - m_readPos);
+        m_readPos = newlineIndex + 1;
+        m_scanPos = m_readPos;
+        handleLine(line);
+    }
+
+    if (m_readPos == m_buffer.size()) {
+        m_buffer.truncate(0); // Keeps the allocation
+        m_readPos = 0;
+        m_scanPos = 0;
+    } else if (m_readPos >= kCompactThreshold && m_readPos >= m_buffer.size() - m_readPos) {
+        m_buffer.remove(0, m_readPos);
+        m_scanPos -= m_readPos;
+        m_readPos = 0;
+    }
+}
+
+void JsonRpcClient::handleLine(QByteArrayView line) {
+    if (line.trimmed().isEmpty()) return;
+    if (isUnsubscribedNotification(line)) return;
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(line.data(), line.size()), &parseError);
+    if (parseError.error == QJsonParseError::NoError && doc.isObject()) {
+        handleMessage(doc.object());
+    } else {
+        qWarning() << "JsonRpcClient: Failed to parse JSON:" << line.left(200);
+    }
+}
+
+bool JsonRpcClient::isUnsubscribedNotification(QByteArrayView line) const {
+    if (m_subscriptions.isEmpty()) return false;
+
+    // Only a line with a method and no id anywhere is surely a notification;
+    // anything ambiguous gets the full parse
+    if (!line.contains("\"method\"") || line.contains("\"id\"")) return false;
+    for (const QByteArray &needle : m_subscriptions) {
+        if (line.contains(needle)) return false;
+    }
+    return true;
+}
+
+void JsonRpcClient::handleMessage(const QJsonObject &message) {
+    const QJsonValue id = message["id"];
+    const bool hasMethod = message.contains("method");
+
+    if (!id.isUndefined() && !hasMethod) {
+        // Response to one of our calls
+        if (message.contains("error")) {
+            const QJsonObject err = message["error"].toObject();
+            complete(id.toInt(), QJsonValue(), {err["code"].toInt(), err["message"].toString()});
+        } else {
+            complete(id.toInt(), message["result"], {});
+        }
+    } else if (hasMethod && id.isUndefined()) {
+        emit notificationReceived(message["method"].toString(), message["params"].toObject());
+    } else if (hasMethod) {
+        // Requests from the server are not supported, answer so it does not wait on us
+        QJsonObject error;
+        error["code"] = -32601;
+        error["message"] = "Method not found";
+        QJsonObject response;
+        response["id"] = id;
+        response["error"] = error;
+        send(response);
+    }
+}
+
+void JsonRpcClient::complete(int id, const QJsonValue &result, const JsonRpcError &error) {
+    // Remove first: the callback may issue new calls
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) return;
+    PendingCall pending = std::move(it.value());
+    m_pending.erase(it);
+    armDeadlineTimer();
+
+    if (error.isError()) {
+        qDebug() << "JsonRpcClient:" << pending.method << "failed:" << error.message;
+    }
+    if (pending.callback) {
+        pending.callback(result, error);
+    }
+}
+
+void JsonRpcClient::onDeadlineExpired() {
+    QList<int> expired;
+    for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+        if (it.value().deadline.hasExpired()) expired.append(it.key());
+    }
+    for (int id : std::as_const(expired)) {
+        complete(id, QJsonValue(), {JsonRpcError::Timeout, "timed out"});
+    }
+    armDeadlineTimer();
+}
+
+void JsonRpcClient::armDeadlineTimer() {
+    // One timer for the whole table, due at the earliest deadline
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    for (const PendingCall &pending : std::as_const(m_pending)) {
+        earliest = qMin(earliest, pending.deadline.remainingTime());
+    }
+    if (m_pending.isEmpty()) {
+        m_deadlineTimer.stop();
+    } else {
+        m_deadlineTimer.start(static_cast<int>(qMax<qint64>(earliest, 0)));
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <functional>
+
+class QIODevice;
+
+struct JsonRpcError {
+    // Local failures use codes from the JSON-RPC "server error" range
+    enum Code {
+        None = 0,
+        Timeout = -32001,
+        Cancelled = -32002,
+        Disconnected = -32003
+    };
+
+    int code = None;
+    QString message;
+
+    bool isError() const { return code != None; }
+};
+
+// JSON-RPC client over newline-delimited JSON on a QIODevice, typically a
+// QProcess' stdin/stdout. Any number of calls can be in flight over the one
+// pipe; each completes exactly once with a result, a server error, a
+// timeout or a cancellation, so a silent peer can never stall the caller.
+class JsonRpcClient : public QObject {
+    Q_OBJECT
+public:
+    using Callback = std::function<void(const QJsonValue &result, const JsonRpcError &error)>;
+
+    static constexpr int kDefaultTimeoutMs = 15000;
+
+    explicit JsonRpcClient(QIODevice *device, QObject *parent = nullptr);
+    ~JsonRpcClient() override;
+
+    // Returns the request id, usable with cancel()
+    int call(const QString &method, const QJsonObject &params, Callback callback,
+             int timeoutMs = kDefaultTimeoutMs);
+    void notify(const QString &method, const QJsonObject &params = QJsonObject());
+
+    // Once anything is subscribed, notifications for other methods are
+    // dropped without being parsed
+    void subscribe(const QString &method);
+
+    void cancel(int id);
+    // Fails every pending call, e.g. when the peer process exited
+    void failAll(const QString &reason);
+    int pendingCount() const;
+
+signals:
+    void notificationReceived(const QString &method, const QJsonObject &params);
+
+private slots:
+    void onReadyRead();
+    void onDeadlineExpired();
+
+private:
+    struct PendingCall {
+        QString method;
+        Callback callback;
+        QDeadlineTimer deadline;
+    };
+
+    void send(const QJsonObject &payload);
+    void handleLine(QByteArrayView line);
+    bool isUnsubscribedNotification(QByteArrayView line) const;
+    void handleMessage(const QJsonObject &message);
+    void complete(int id, const QJsonValue &result, const JsonRpcError &error);
+    void armDeadlineTimer();
+
+    QIODevice *m_device;
+    // Lines before m_readPos were consumed; m_scanPos is where the search
+    // for the next newline resumes
+    QByteArray m_buffer;
+    qsizetype m_readPos = 0;
+    qsizetype m_scanPos = 0;
+    QList<QByteArray> m_subscriptions; // Quoted method names
+    int m_nextId = 1;
+    QHash<int, PendingCall> m_pending;
+    QTimer m_deadlineTimer;
+};
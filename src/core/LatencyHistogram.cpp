@@ -0,0 +1,44 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(const QString &name)
+    : m_name(name)
+{
+}
+
+void LatencyHistogram::record(qint64 ms) {
+    ms = std::max<qint64>(ms, 0);
+    // Bucket i holds values up to 2^i ms
+    int bucket = ms <= 1 ? 0 : std::bit_width(static_cast<quint64>(ms - 1));
+    m_buckets[std::min(bucket, kBuckets - 1)]++;
+    m_count++;
+    m_max = std::max(m_max, ms);
+}
+
+void LatencyHistogram::clear() {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+qint64 LatencyHistogram::percentile(double p) const {
+    if (m_count == 0) return 0;
+    const int rank = std::max(1, static_cast<int>(std::ceil(p / 100.0 * m_count)));
+    int seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) return std::min<qint64>(qint64(1) << i, m_max);
+    }
+    return m_max;
+}
+
+QString LatencyHistogram::summary() const {
+    return QString("%1: n=%2 p50<=%3ms p90<=%4ms max=%5ms")
+        .arg(m_name)
+        .arg(m_count)
+        .arg(percentile(50))
+        .arg(percentile(90))
+        .arg(m_max);
+}
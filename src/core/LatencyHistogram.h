@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QString>
+#include <array>
+
+// Power-of-two millisecond buckets, cheap enough to record every refresh.
+// Percentiles resolve to the upper bound of the bucket they fall in.
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(const QString &name = QString());
+
+    void record(qint64 ms);
+    void clear();
+
+    int count() const { return m_count; }
+    qint64 max() const { return m_max; }
+    qint64 percentile(double p) const;
+
+    // e.g. "claude.ready: n=12 p50<=512ms p90<=2048ms max=1893ms"
+    QString summary() const;
+
+private:
+    static constexpr int kBuckets = 24; // Up to ~2.3h
+
+    QString m_name;
+    std::array<int, kBuckets> m_buckets{};
+    int m_count = 0;
+    qint64 m_max = 0;
+};
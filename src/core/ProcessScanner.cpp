@@ -0,0 +1,142 @@
+#include "ProcessScanner.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <QFileInfo>
+#include <algorithm>
+
+// procfs files report a size of 0, so read until EOF into a small buffer
+static QByteArray readProcFile(const QByteArray &path, qsizetype limit = 64 * 1024) {
+    int fd = ::open(path.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return QByteArray();
+
+    QByteArray data;
+    char buffer[4096];
+    while (data.size() < limit) {
+        ssize_t n = ::read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        data.append(buffer, n);
+    }
+    ::close(fd);
+    return data;
+}
+
+static quint64 parseStartTime(const QByteArray &stat) {
+    // comm may contain spaces and parentheses; fields resume after the last ')'
+    const qsizetype close = stat.lastIndexOf(')');
+    if (close < 0) return 0;
+
+    // Field 3 (state) is the first after comm, start time is field 22
+    int field = 2;
+    qsizetype pos = close + 1;
+    while (pos < stat.size()) {
+        while (pos < stat.size() && stat.at(pos) == ' ') ++pos;
+        if (pos >= stat.size()) break;
+        ++field;
+        qsizetype end = stat.indexOf(' ', pos);
+        if (end < 0) end = stat.size();
+        if (field == 22) return stat.mid(pos, end - pos).toULongLong();
+        pos = end;
+    }
+    return 0;
+}
+
+QList<ProcessScanner::Process> ProcessScanner::find(const QString &name, const QString &procRoot) {
+    QList<Process> result;
+    const QByteArray root = procRoot.toLocal8Bit();
+    const QByteArray comm = name.left(kCommLength).toLocal8Bit();
+
+    DIR *dir = ::opendir(root.constData());
+    if (!dir) return result;
+
+    while (dirent *entry = ::readdir(dir)) {
+        // Only numeric entries are processes
+        char *end = nullptr;
+        const long pid = std::strtol(entry->d_name, &end, 10);
+        if (pid <= 0 || *end != '\0') continue;
+
+        const QByteArray base = root + '/' + entry->d_name + '/';
+        if (readProcFile(base + "comm", 64).trimmed() != comm) continue;
+
+        const QByteArray cmdline = readProcFile(base + "cmdline");
+        if (cmdline.isEmpty()) continue; // Kernel thread or already exited
+
+        Process process;
+        process.pid = static_cast<int>(pid);
+        for (const QByteArray &arg : cmdline.split('\0')) {
+            if (!arg.isEmpty()) process.arguments.append(QString::fromLocal8Bit(arg));
+        }
+        if (process.arguments.isEmpty()) continue;
+
+        // A truncated comm also matches other names with the same prefix
+        if (name.size() > kCommLength && QFileInfo(process.arguments.first()).fileName() != name) continue;
+
+        process.startTime = parseStartTime(readProcFile(base + "stat"));
+        result.append(process);
+    }
+
+    ::closedir(dir);
+    return result;
+}
+
+quint64 ProcessScanner::startTime(int pid, const QString &procRoot) {
+    return parseStartTime(readProcFile(procRoot.toLocal8Bit() + '/' + QByteArray::number(pid) + "/stat"));
+}
+
+QList<int> ProcessScanner::listeningPorts(int pid, const QString &procRoot) {
+    const QByteArray base = procRoot.toLocal8Bit() + '/' + QByteArray::number(pid) + '/';
+
+    // Socket fds link to "socket:[<inode>]"
+    QSet<quint64> inodes;
+    const QByteArray fdDir = base + "fd";
+    DIR *dir = ::opendir(fdDir.constData());
+    if (!dir) return {};
+    while (dirent *entry = ::readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        char target[64];
+        const QByteArray link = fdDir + '/' + entry->d_name;
+        const ssize_t n = ::readlink(link.constData(), target, sizeof(target) - 1);
+        if (n <= 0) continue;
+        const QByteArrayView view(target, n);
+        if (!view.startsWith("socket:[") || !view.endsWith("]")) continue;
+        inodes.insert(QByteArray(target + 8, n - 9).toULongLong());
+    }
+    ::closedir(dir);
+    if (inodes.isEmpty()) return {};
+
+    // The process' own view, in case it runs in another network namespace
+    QList<int> ports = parseListeningPorts(readProcFile(base + "net/tcp", 1024 * 1024), inodes);
+    for (int port : parseListeningPorts(readProcFile(base + "net/tcp6", 1024 * 1024), inodes)) {
+        if (!ports.contains(port)) ports.append(port);
+    }
+    std::sort(ports.begin(), ports.end());
+    return ports;
+}
+
+QList<int> ProcessScanner::parseListeningPorts(const QByteArray &table, const QSet<quint64> &inodes) {
+    // "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode"
+    // "   0: 0100007F:8F4F 00000000:0000 0A 00000000:00000000 00:00000000 00000000  1000        0 123456 ..."
+    static constexpr int kLocalAddress = 1;
+    static constexpr int kState = 3;
+    static constexpr int kInode = 9;
+
+    QList<int> ports;
+    const QList<QByteArray> lines = table.split('\n');
+    for (qsizetype i = 1; i < lines.size(); ++i) { // First line is the header
+        const QList<QByteArray> fields = lines[i].simplified().split(' ');
+        if (fields.size() <= kInode) continue;
+        if (fields[kState] != "0A") continue; // TCP_LISTEN
+        if (!inodes.contains(fields[kInode].toULongLong())) continue;
+
+        const QByteArray &local = fields[kLocalAddress];
+        const qsizetype colon = local.lastIndexOf(':');
+        if (colon < 0) continue;
+        bool ok = false;
+        const int port = local.mid(colon + 1).toInt(&ok, 16);
+        if (ok && port > 0 && !ports.contains(port)) ports.append(port);
+    }
+    return ports;
+}
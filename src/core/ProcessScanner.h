@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// Finds processes by reading procfs directly instead of running ps(1).
+// Only processes whose comm matches are opened any further, so a scan
+// costs one small read per process plus the cmdline of the candidates.
+class ProcessScanner {
+public:
+    struct Process {
+        int pid = 0;
+        QStringList arguments; // argv, including argv[0]
+        quint64 startTime = 0; // Clock ticks after boot, /proc/<pid>/stat field 22
+    };
+
+    // Processes of any user we can read whose executable name is `name`.
+    // The kernel truncates comm to 15 characters, so longer names are
+    // matched on their prefix and then checked against argv[0].
+    static QList<Process> find(const QString &name, const QString &procRoot = "/proc");
+
+    // 0 when the process is gone
+    static quint64 startTime(int pid, const QString &procRoot = "/proc");
+
+    // TCP ports the process listens on, sorted: its socket inodes from
+    // /proc/<pid>/fd joined with the LISTEN rows of its net/tcp and tcp6.
+    // Needs the same UID as the process, like lsof without root.
+    static QList<int> listeningPorts(int pid, const QString &procRoot = "/proc");
+
+    // Ports of LISTEN rows in a /proc/net/tcp or tcp6 table whose inode
+    // is in `inodes`
+    static QList<int> parseListeningPorts(const QByteArray &table, const QSet<quint64> &inodes);
+
+    static constexpr int kCommLength = 15;
+};
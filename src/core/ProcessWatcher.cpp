@@ -0,0 +1,215 @@
+#include "ProcessWatcher.h"
+#include "ProcessScanner.h"
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSocketNotifier>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// Kernel ABI values. Newer headers moved the enum out of struct
+// proc_event, so neither spelling of the names compiles everywhere.
+static constexpr quint32 kProcEventNone = 0x00000000;
+static constexpr quint32 kProcEventExec = 0x00000002;
+static constexpr quint32 kProcEventExit = 0x80000000;
+
+// The kernel queues its ack before send() returns; callers outside the
+// initial user or PID namespace get none at all
+static constexpr int kSubscribeAckTimeoutMs = 1000;
+
+ProcessWatcher::ProcessWatcher(const QString &name, QObject *parent)
+    : QObject(parent)
+    , m_name(name)
+{
+    connect(&m_dirWatcher, &QFileSystemWatcher::directoryChanged, this, &ProcessWatcher::rescanNeeded);
+
+    m_subscribeTimeout.setSingleShot(true);
+    connect(&m_subscribeTimeout, &QTimer::timeout, this, [this]() {
+        qDebug() << "ProcessWatcher: no proc connector acknowledgement";
+        closeProcConnector();
+    });
+
+    if (openProcConnector()) {
+        m_subscribeTimeout.start(kSubscribeAckTimeoutMs);
+    } else {
+        qDebug() << "ProcessWatcher: proc connector unavailable, falling back to inotify and pidfd";
+    }
+}
+
+ProcessWatcher::~ProcessWatcher() {
+    if (m_netlinkFd != -1) ::close(m_netlinkFd);
+    for (const PidWatch &watch : std::as_const(m_pids)) {
+        ::close(watch.fd);
+    }
+}
+
+bool ProcessWatcher::openProcConnector() {
+    int fd = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd < 0) return false;
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    address.nl_pid = 0; // Assigned by the kernel
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // nlmsghdr + cn_msg + op, as one datagram
+    alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+    auto *header = reinterpret_cast<nlmsghdr *>(buffer);
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    auto *message = static_cast<cn_msg *>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(proc_cn_mcast_op);
+    const proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(message->data, &op, sizeof(op));
+
+    if (::send(fd, header, header->nlmsg_len, 0) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // send() succeeds even where the kernel refuses the subscription; the
+    // CAP_NET_ADMIN check only reports its result in a PROC_EVENT_NONE ack
+    m_netlinkFd = fd;
+    m_netlinkNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_netlinkNotifier, &QSocketNotifier::activated, this, &ProcessWatcher::readProcConnector);
+    return true;
+}
+
+void ProcessWatcher::closeProcConnector() {
+    m_subscribeTimeout.stop();
+    m_subscribed = false;
+    if (m_netlinkFd == -1) return;
+
+    // May run from the notifier's own signal
+    m_netlinkNotifier->setEnabled(false);
+    m_netlinkNotifier->deleteLater();
+    m_netlinkNotifier = nullptr;
+    ::close(m_netlinkFd);
+    m_netlinkFd = -1;
+    qDebug() << "ProcessWatcher: proc connector unavailable, falling back to inotify and pidfd";
+}
+
+void ProcessWatcher::readProcConnector() {
+    alignas(nlmsghdr) char buffer[8192];
+
+    while (true) {
+        const ssize_t length = ::recv(m_netlinkFd, buffer, sizeof(buffer), 0);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            // The socket buffer overflowed and events were dropped
+            if (errno == ENOBUFS) {
+                emit rescanNeeded();
+                continue;
+            }
+            break; // EAGAIN: drained
+        }
+        if (length == 0) break;
+
+        auto *header = reinterpret_cast<nlmsghdr *>(buffer);
+        for (int remaining = static_cast<int>(length); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type != NLMSG_DONE) continue;
+
+            const auto *message = static_cast<const cn_msg *>(NLMSG_DATA(header));
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) continue;
+            const auto *event = reinterpret_cast<const proc_event *>(message->data);
+
+            const quint32 what = static_cast<quint32>(event->what);
+            if (what == kProcEventNone) {
+                // Not every kernel echoes our sequence number, so the first
+                // ack is taken as ours
+                if (m_subscribed) continue;
+                if (event->event_data.ack.err != 0) {
+                    qDebug() << "ProcessWatcher: proc connector subscription refused:"
+                             << std::strerror(static_cast<int>(event->event_data.ack.err));
+                    closeProcConnector();
+                    return;
+                }
+                m_subscribeTimeout.stop();
+                m_subscribed = true;
+                qDebug() << "ProcessWatcher: using the proc connector for" << m_name;
+            } else if (what == kProcEventExec) {
+                const int pid = event->event_data.exec.process_tgid;
+                if (matchesName(pid)) emit processStarted(pid);
+            } else if (what == kProcEventExit) {
+                // Thread exits share the event; only the leader ends the process
+                const int pid = event->event_data.exit.process_pid;
+                if (pid == event->event_data.exit.process_tgid && m_pids.contains(pid)) {
+                    onPidFdReadable(pid);
+                }
+            }
+        }
+    }
+}
+
+bool ProcessWatcher::matchesName(int pid) const {
+    // Same comm rule as ProcessScanner, one file read per exec
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char comm[32];
+    const ssize_t n = ::read(fd, comm, sizeof(comm));
+    ::close(fd);
+    if (n <= 0) return false;
+    return QByteArray(comm, n).trimmed() == m_name.left(ProcessScanner::kCommLength).toLocal8Bit();
+}
+
+void ProcessWatcher::watchPid(int pid) {
+    if (m_pids.contains(pid)) return;
+
+    const int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (fd < 0) {
+        // Gone already, or a kernel before 5.3; the proc connector or the
+        // next rescan will notice
+        if (errno == ESRCH) emit processExited(pid);
+        return;
+    }
+
+    PidWatch watch;
+    watch.fd = fd;
+    watch.notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(watch.notifier, &QSocketNotifier::activated, this, [this, pid]() { onPidFdReadable(pid); });
+    m_pids.insert(pid, watch);
+}
+
+void ProcessWatcher::onPidFdReadable(int pid) {
+    // Reached from the pidfd or from a netlink exit event, whichever is first
+    auto it = m_pids.find(pid);
+    if (it == m_pids.end()) return;
+    const PidWatch watch = it.value();
+    m_pids.erase(it);
+
+    watch.notifier->setEnabled(false);
+    watch.notifier->deleteLater();
+    ::close(watch.fd);
+    emit processExited(pid);
+}
+
+void ProcessWatcher::setWatchedDirectories(const QStringList &paths) {
+    const QStringList watched = m_dirWatcher.directories();
+    for (const QString &path : watched) {
+        if (!paths.contains(path)) m_dirWatcher.removePath(path);
+    }
+    for (const QString &path : paths) {
+        if (path.isEmpty() || watched.contains(path)) continue;
+        if (QFileInfo(path).isDir()) m_dirWatcher.addPath(path);
+    }
+}
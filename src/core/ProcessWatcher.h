@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QTimer>
+
+class QSocketNotifier;
+
+// Reports when processes with a given name start and exit, without
+// polling. The netlink proc connector delivers exec/exit events where we
+// are allowed to subscribe (it needs CAP_NET_ADMIN). Otherwise starts are
+// inferred from activity in watched directories (inotify), and exits of
+// known processes still arrive through pidfds.
+//
+// The subscription is provisional until the kernel acknowledges it; the
+// ack is read from the socket notifier, so nothing blocks at startup.
+class ProcessWatcher : public QObject {
+    Q_OBJECT
+public:
+    explicit ProcessWatcher(const QString &name, QObject *parent = nullptr);
+    ~ProcessWatcher() override;
+
+    // True once the kernel acknowledged the subscription, i.e. exec events
+    // are delivered and a missed start is unlikely
+    bool usesProcConnector() const { return m_subscribed; }
+
+    // Report the exit of a process found by other means
+    void watchPid(int pid);
+    // Fallback start detection: a server writes into its data directory.
+    // Replaces the watched set; directories not listed are dropped.
+    void setWatchedDirectories(const QStringList &paths);
+
+signals:
+    void processStarted(int pid);
+    void processExited(int pid);
+    // Started processes may have been missed (fallback activity or lost
+    // netlink messages); the receiver should rescan
+    void rescanNeeded();
+
+private:
+    bool openProcConnector();
+    void closeProcConnector();
+    void readProcConnector();
+    void onPidFdReadable(int pid);
+    bool matchesName(int pid) const;
+
+    QString m_name;
+    int m_netlinkFd = -1;
+    QSocketNotifier *m_netlinkNotifier = nullptr;
+    bool m_subscribed = false;
+    QTimer m_subscribeTimeout;
+
+    struct PidWatch {
+        int fd = -1;
+        QSocketNotifier *notifier = nullptr;
+    };
+    QHash<int, PidWatch> m_pids;
+    QFileSystemWatcher m_dirWatcher;
+};
@@ -53,9 +53,19 @@ public:
     // Abstract method to be implemented by specific strategies
     virtual void refresh() = 0;
 
+    // True when a refresh starts a local CLI rather than only sending
+    // requests; the scheduler limits how many of those run at once
+    virtual bool spawnsProcess() const { return false; }
+
 signals:
     void dataChanged();
     void stateChanged(ProviderState newState);
+    // Asks the scheduler for a refresh (a server restarted, a new process
+    // appeared); providers never call refresh() on themselves
+    void refreshRequested();
+    // refresh() returned without starting anything (already running, nothing
+    // to query, failed up front) and no data or state change will follow
+    void refreshSkipped();
 
 protected:
     void setSnapshot(const UsageSnapshot &snapshot);
@@ -1,12 +1,32 @@
 #include "PtySession.h"
+#include "BinaryLocator.h"
 #include <pty.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <spawn.h>
 #include <csignal>
+#include <cerrno>
+#include <cstring>
 #include <vector>
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// Read granularity while draining the master fd
+static constexpr qsizetype kReadChunk = 16 * 1024;
+// How long the child gets to honour SIGTERM before it is killed
+static constexpr int kTerminateGraceMs = 2000;
+// Fallback reap polling interval when pidfd_open is unavailable
+static constexpr int kReapPollMs = 20;
 
 PtySession::PtySession(QObject *parent)
     : QObject(parent)
@@ -14,22 +34,80 @@ PtySession::PtySession(QObject *parent)
     , m_pid(-1)
     , m_notifier(nullptr)
 {
+    m_killTimer.setSingleShot(true);
+    connect(&m_killTimer, &QTimer::timeout, this, [this]() {
+        if (m_pid == -1) return;
+        qDebug() << "PtySession: PID" << m_pid << "ignored SIGTERM, sending SIGKILL";
+        kill(m_pid, SIGKILL);
+    });
+
+    connect(&m_reapPoll, &QTimer::timeout, this, &PtySession::reapChild);
+
+    m_replayTimer.setSingleShot(true);
+    connect(&m_replayTimer, &QTimer::timeout, this, &PtySession::replayNext);
 }
 
 PtySession::~PtySession() {
     close();
+
+    // Destroyed before the child went away — nobody is left to reap it
+    // asynchronously, and SIGKILL keeps this wait short
+    if (m_pid != -1) {
+        kill(m_pid, SIGKILL);
+        waitpid(m_pid, nullptr, 0);
+        releasePidFd();
+    }
 }
 
 bool PtySession::start(const QString &program, const QStringList &arguments) {
-    if (isRunning()) return false;
+    // Also refuse while a previous child is still being reaped
+    if (m_pid != -1 || m_replaying) return false;
+
+    // Resolve the binary once in the parent, so the child does no PATH walk
+    const QString executable = program.contains('/') ? program : BinaryLocator::instance()->find(program);
+    if (executable.isEmpty()) {
+        qCritical() << "PtySession: executable not found:" << program;
+        return false;
+    }
+
+    // Build argv/envp before spawning — the child only execs
+    const QByteArray executableBytes = executable.toLocal8Bit();
+    std::vector<QByteArray> argStorage;
+    argStorage.reserve(arguments.size() + 1);
+    argStorage.push_back(program.toLocal8Bit());
+    for (const auto &arg : arguments) {
+        argStorage.push_back(arg.toLocal8Bit());
+    }
+    std::vector<char*> args;
+    args.reserve(argStorage.size() + 1);
+    for (auto &arg : argStorage) {
+        args.push_back(arg.data());
+    }
+    args.push_back(nullptr);
+
+    // Ensure terminal env vars are set for proper TUI rendering
+    // Desktop launches lack these, causing claude to show the theme picker
+    static char kDefaultTerm[] = "TERM=xterm-256color";
+    static char kDefaultColorTerm[] = "COLORTERM=truecolor";
+    std::vector<char*> env;
+    bool hasTerm = false;
+    bool hasColorTerm = false;
+    for (char **e = environ; e && *e; ++e) {
+        if (strncmp(*e, "TERM=", 5) == 0) hasTerm = true;
+        else if (strncmp(*e, "COLORTERM=", 10) == 0) hasColorTerm = true;
+        env.push_back(*e);
+    }
+    if (!hasTerm) env.push_back(kDefaultTerm);
+    if (!hasColorTerm) env.push_back(kDefaultColorTerm);
+    env.push_back(nullptr);
 
     int masterFd, slaveFd;
     char slaveName[1024];
 
     // Set a reasonable terminal size — desktop launches have no inherited size
     struct winsize ws = {};
-    ws.ws_row = 40;
-    ws.ws_col = 120;
+    ws.ws_row = static_cast<unsigned short>(m_rows);
+    ws.ws_col = static_cast<unsigned short>(m_columns);
 
     // Create pseudo-terminal
     if (openpty(&masterFd, &slaveFd, slaveName, nullptr, &ws) == -1) {
@@ -37,55 +115,44 @@ bool PtySession::start(const QString &program, const QStringList &arguments) {
         return false;
     }
 
-    m_pid = fork();
-    if (m_pid == -1) {
-        qCritical() << "fork failed";
-        ::close(masterFd);
-        ::close(slaveFd);
-        return false;
-    }
+    // Only the slave opened by the file actions below may reach the child
+    fcntl(masterFd, F_SETFD, FD_CLOEXEC);
+    fcntl(slaveFd, F_SETFD, FD_CLOEXEC);
 
-    if (m_pid == 0) {
-        // Child process
-        ::close(masterFd);
+    // posix_spawn uses clone(CLONE_VM | CLONE_VFORK) in glibc, so there is no
+    // copy-on-write duplication of our Qt heap. As a new session leader the
+    // child acquires the slave as its controlling TTY when opening it.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
 
-        // Setup session
-        setsid();
-        if (ioctl(slaveFd, TIOCSCTTY, nullptr) == -1) {
-            // non-fatal
-        }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, slaveName, O_RDWR, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO);
 
-        // Duplicate standard file descriptors
-        dup2(slaveFd, STDIN_FILENO);
-        dup2(slaveFd, STDOUT_FILENO);
-        dup2(slaveFd, STDERR_FILENO);
-        if (slaveFd > STDERR_FILENO) ::close(slaveFd);
-
-        // Ensure terminal env vars are set for proper TUI rendering
-        // Desktop launches lack these, causing claude to show the theme picker
-        setenv("TERM", "xterm-256color", 0);
-        setenv("COLORTERM", "truecolor", 0);
-
-        // Prepare args
-        std::vector<char*> args;
-        QByteArray programBytes = program.toLocal8Bit();
-        args.push_back(programBytes.data());
-
-        // Hold data alive
-        std::vector<QByteArray> argStorage;
-        for (const auto &arg : arguments) {
-            argStorage.push_back(arg.toLocal8Bit());
-            args.push_back(argStorage.back().data());
-        }
-        args.push_back(nullptr);
+    QElapsedTimer spawnTimer;
+    spawnTimer.start();
+    pid_t pid = -1;
+    int spawnError = posix_spawn(&pid, executableBytes.constData(), &actions, &attr, args.data(), env.data());
+    const qint64 spawnNs = spawnTimer.nsecsElapsed();
 
-        // Execute
-        execvp(args[0], args.data());
-        
-        // If execvp returns, it failed
-        perror("execvp failed");
-        _exit(1);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    if (spawnError != 0) {
+        qCritical() << "posix_spawn failed:" << strerror(spawnError);
+        ::close(masterFd);
+        ::close(slaveFd);
+        return false;
     }
+    m_pid = pid;
 
     // Parent process
     ::close(slaveFd);
@@ -99,17 +166,88 @@ bool PtySession::start(const QString &program, const QStringList &arguments) {
     m_notifier = new QSocketNotifier(m_masterFd, QSocketNotifier::Read, this);
     connect(m_notifier, &QSocketNotifier::activated, this, &PtySession::onReadActivated);
 
-    qDebug() << "PtySession started PID:" << m_pid;
+    qDebug() << "PtySession started PID:" << m_pid << "spawn took" << spawnNs / 1000 << "us";
+
+    QString recordingPath = m_recordingPath;
+    const QString recordDir = qEnvironmentVariable("CODEXBAR_PTY_RECORD");
+    if (recordingPath.isEmpty() && !recordDir.isEmpty()) {
+        recordingPath = QDir(recordDir).filePath(QString("%1-%2.cxpt")
+            .arg(QFileInfo(program).fileName(), QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz")));
+    }
+    if (!recordingPath.isEmpty() && m_recorder.open(recordingPath, m_rows, m_columns)) {
+        qDebug() << "PtySession: Recording transcript to" << recordingPath;
+    }
     return true;
 }
 
+bool PtySession::startReplay(const QString &transcriptPath, ReplaySpeed speed) {
+    if (m_pid != -1 || m_replaying) return false;
+    if (!PtyTranscript::load(transcriptPath, &m_replay)) return false;
+
+    m_rows = m_replay.rows;
+    m_columns = m_replay.columns;
+    m_replaying = true;
+    m_replaySpeed = speed;
+    m_replayIndex = 0;
+    m_replayClock.start();
+    m_replayTimer.start(0);
+
+    qDebug() << "PtySession: Replaying" << m_replay.chunks.size() << "chunks from" << transcriptPath;
+    return true;
+}
+
+void PtySession::replayNext() {
+    if (!m_replaying) return;
+
+    // Emit the next output chunk, skipping the recorded input
+    while (m_replayIndex < m_replay.chunks.size()) {
+        const PtyTranscript::Chunk &chunk = m_replay.chunks.at(m_replayIndex);
+        if (chunk.direction != PtyTranscript::Direction::Output) {
+            ++m_replayIndex;
+            continue;
+        }
+        if (m_replaySpeed == ReplaySpeed::Recorded) {
+            const qint64 waitMs = chunk.offsetUs / 1000 - m_replayClock.elapsed();
+            if (waitMs > 0) {
+                m_replayTimer.start(static_cast<int>(waitMs));
+                return;
+            }
+        }
+        ++m_replayIndex;
+        emit dataRead(chunk.data);
+
+        // Chunk boundaries are preserved: one chunk per event-loop turn
+        if (m_replaying) m_replayTimer.start(0);
+        return;
+    }
+
+    m_replaying = false;
+    emit processExited(0);
+}
+
+void PtySession::setRecordingPath(const QString &path) {
+    m_recordingPath = path;
+}
+
 void PtySession::write(const QByteArray &data) {
     if (m_masterFd != -1) {
         ::write(m_masterFd, data.constData(), data.size());
+        m_recorder.append(PtyTranscript::Direction::Input, data);
     }
 }
 
 void PtySession::close() {
+    m_readBuffer.resize(0);
+    m_flushPending = false;
+    m_recorder.close();
+
+    if (m_replaying) {
+        m_replaying = false;
+        m_replayTimer.stop();
+        emit processExited(0);
+        return;
+    }
+
     if (m_notifier) {
         m_notifier->setEnabled(false);
         m_notifier->deleteLater();
@@ -121,40 +259,139 @@ void PtySession::close() {
         m_masterFd = -1;
     }
 
-    if (m_pid != -1) {
+    if (m_pid != -1 && !m_closing) {
+        m_closing = true;
         kill(m_pid, SIGTERM);
-        // Try non-blocking reap first, then SIGKILL if needed
-        int status = 0;
-        if (waitpid(m_pid, &status, WNOHANG) == 0) {
-            // Process hasn't exited yet — give it a moment, then force kill
-            usleep(100000); // 100ms
-            if (waitpid(m_pid, &status, WNOHANG) == 0) {
-                kill(m_pid, SIGKILL);
-                waitpid(m_pid, &status, 0);
-            }
+
+        // Reap asynchronously — the GUI thread never waits on the child
+        m_pidFd = static_cast<int>(syscall(SYS_pidfd_open, m_pid, 0));
+        if (m_pidFd != -1) {
+            m_pidNotifier = new QSocketNotifier(m_pidFd, QSocketNotifier::Read, this);
+            connect(m_pidNotifier, &QSocketNotifier::activated, this, &PtySession::reapChild);
+        } else {
+            // Kernels before 5.3 have no pidfd, poll with WNOHANG instead
+            m_reapPoll.start(kReapPollMs);
         }
-        m_pid = -1;
-        emit processExited(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        m_killTimer.start(kTerminateGraceMs);
+
+        // The child may already be gone (EOF path)
+        reapChild();
     }
 }
 
 bool PtySession::isRunning() const {
-    return m_pid != -1;
+    return (m_pid != -1 && !m_closing) || m_replaying;
+}
+
+void PtySession::reapChild() {
+    if (m_pid == -1) return;
+
+    int status = 0;
+    pid_t result = waitpid(m_pid, &status, WNOHANG);
+    if (result == 0) return; // Still running
+
+    // -1 means it was reaped elsewhere (ECHILD), so the status is unknown
+    int exitCode = (result == m_pid && WIFEXITED(status)) ? WEXITSTATUS(status) : -1;
+
+    m_killTimer.stop();
+    m_reapPoll.stop();
+    releasePidFd();
+    m_pid = -1;
+    m_closing = false;
+
+    emit processExited(exitCode);
+}
+
+void PtySession::releasePidFd() {
+    if (m_pidNotifier) {
+        m_pidNotifier->setEnabled(false);
+        m_pidNotifier->deleteLater();
+        m_pidNotifier = nullptr;
+    }
+    if (m_pidFd != -1) {
+        ::close(m_pidFd);
+        m_pidFd = -1;
+    }
+}
+
+void PtySession::setWindowSize(int rows, int columns) {
+    m_rows = qBound(1, rows, 1000);
+    m_columns = qBound(1, columns, 1000);
+}
+
+int PtySession::rows() const {
+    return m_rows;
+}
+
+int PtySession::columns() const {
+    return m_columns;
+}
+
+void PtySession::setHighWaterMark(qsizetype bytes) {
+    m_highWaterMark = qMax<qsizetype>(bytes, 1);
+}
+
+qsizetype PtySession::highWaterMark() const {
+    return m_highWaterMark;
 }
 
 void PtySession::onReadActivated(int socket) {
     if (socket != m_masterFd) return;
 
-    char buffer[4096];
-    ssize_t bytesRead = ::read(m_masterFd, buffer, sizeof(buffer));
+    // Drain until EAGAIN so one wakeup covers a whole burst of TUI output
+    bool eof = false;
+    while (m_masterFd != -1) {
+        const qsizetype used = m_readBuffer.size();
+        if (m_readBuffer.capacity() - used < kReadChunk)
+            m_readBuffer.reserve(qMax(m_readBuffer.capacity() * 2, used + kReadChunk));
+        m_readBuffer.resize(used + kReadChunk);
 
-    if (bytesRead > 0) {
-        emit dataRead(QByteArray(buffer, bytesRead));
-    } else if (bytesRead < 0 && errno != EAGAIN) {
-        // Error or EOF
-        close();
-    } else if (bytesRead == 0) {
-        // EOF
+        ssize_t bytesRead = ::read(m_masterFd, m_readBuffer.data() + used, kReadChunk);
+        m_readBuffer.resize(used + qMax<ssize_t>(bytesRead, 0));
+
+        if (bytesRead > 0) {
+            // Past the high-water mark: hand over what we have and yield to the
+            // event loop, the notifier fires again for whatever is left
+            if (m_readBuffer.size() >= m_highWaterMark) {
+                flushReadBuffer();
+                return;
+            }
+            continue;
+        }
+        if (bytesRead < 0 && errno == EINTR) continue;
+        if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        // EOF, or EIO once the slave side has been closed by the child
+        eof = true;
+        break;
+    }
+
+    if (eof) {
+        flushReadBuffer();
         close();
+        return;
     }
+
+    scheduleFlush();
+}
+
+void PtySession::scheduleFlush() {
+    if (m_flushPending || m_readBuffer.isEmpty()) return;
+    m_flushPending = true;
+    QMetaObject::invokeMethod(this, &PtySession::flushReadBuffer, Qt::QueuedConnection);
+}
+
+void PtySession::flushReadBuffer() {
+    m_flushPending = false;
+    if (m_readBuffer.isEmpty()) return;
+
+    // Detach the chunk first so receivers may safely close() or write() from the slot
+    QByteArray chunk;
+    chunk.swap(m_readBuffer);
+    m_recorder.append(PtyTranscript::Direction::Output, chunk);
+    emit dataRead(chunk);
+
+    // Hand the allocation back for reuse unless a receiver still shares it
+    chunk.resize(0);
+    if (m_readBuffer.isEmpty()) m_readBuffer.swap(chunk);
 }
@@ -5,6 +5,9 @@
 #include <memory>
 #include <QObject>
 #include <QSocketNotifier>
+#include <QElapsedTimer>
+#include <QTimer>
+#include "PtyTranscript.h"
 
 class PtySession : public QObject {
     Q_OBJECT
@@ -14,19 +17,75 @@ public:
 
     bool start(const QString &program, const QStringList &arguments);
     void write(const QByteArray &data);
+    // Closes the PTY and terminates the child without blocking;
+    // processExited is emitted once the child has actually been reaped
     void close();
 
     bool isRunning() const;
 
+    // Replay a recorded transcript instead of running a child: output chunks
+    // are emitted through dataRead either at their recorded pace or one per
+    // event-loop turn, writes are discarded, processExited follows the last chunk
+    enum class ReplaySpeed {
+        Recorded,
+        AsFastAsPossible
+    };
+    bool startReplay(const QString &transcriptPath, ReplaySpeed speed);
+
+    // Record the next session to this transcript file. When unset, the
+    // CODEXBAR_PTY_RECORD environment variable may name a directory instead.
+    void setRecordingPath(const QString &path);
+
+    // Terminal size handed to the child; takes effect on the next start()
+    void setWindowSize(int rows, int columns);
+    int rows() const;
+    int columns() const;
+
+    // Buffered output is flushed early once it reaches this many bytes,
+    // otherwise once per event-loop turn
+    void setHighWaterMark(qsizetype bytes);
+    qsizetype highWaterMark() const;
+
 signals:
+    // Everything read since the last emission, coalesced into one chunk
     void dataRead(const QByteArray &data);
     void processExited(int exitCode);
 
 private slots:
     void onReadActivated(int socket);
+    void reapChild();
+    void replayNext();
 
 private:
+    void scheduleFlush();
+    void flushReadBuffer();
+    void releasePidFd();
+
     int m_masterFd;
     int m_pid;
     QSocketNotifier *m_notifier;
+    int m_rows = 40;
+    int m_columns = 120;
+
+    // Reused across reads; only reallocates if a receiver kept a reference
+    QByteArray m_readBuffer;
+    qsizetype m_highWaterMark = 64 * 1024;
+    bool m_flushPending = false;
+
+    // Asynchronous shutdown: pidfd readiness (or polling) plus a SIGKILL deadline
+    bool m_closing = false;
+    int m_pidFd = -1;
+    QSocketNotifier *m_pidNotifier = nullptr;
+    QTimer m_killTimer;
+    QTimer m_reapPoll;
+
+    QString m_recordingPath;
+    PtyTranscriptWriter m_recorder;
+
+    bool m_replaying = false;
+    ReplaySpeed m_replaySpeed = ReplaySpeed::Recorded;
+    PtyTranscript m_replay;
+    qsizetype m_replayIndex = 0;
+    QElapsedTimer m_replayClock;
+    QTimer m_replayTimer;
 };
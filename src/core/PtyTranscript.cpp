@@ -0,0 +1,83 @@
+#include "PtyTranscript.h"
+#include <QDebug>
+
+// File layout (QDataStream, big endian):
+//   quint32 magic, quint16 version, quint16 rows, quint16 columns
+//   repeated: quint8 direction, quint32 delta in µs since the previous chunk, QByteArray data
+static constexpr quint32 kMagic = 0x43585054; // "CXPT"
+static constexpr quint16 kVersion = 1;
+
+bool PtyTranscript::load(const QString &path, PtyTranscript *transcript) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "PtyTranscript: Could not open" << path;
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_5);
+
+    quint32 magic = 0;
+    quint16 version = 0, rows = 0, columns = 0;
+    in >> magic >> version >> rows >> columns;
+    if (magic != kMagic || version != kVersion || rows == 0 || columns == 0) {
+        qWarning() << "PtyTranscript: Not a transcript:" << path;
+        return false;
+    }
+
+    transcript->rows = rows;
+    transcript->columns = columns;
+    transcript->chunks.clear();
+
+    qint64 offsetUs = 0;
+    while (!in.atEnd()) {
+        quint8 direction = 0;
+        quint32 deltaUs = 0;
+        QByteArray data;
+        in >> direction >> deltaUs >> data;
+        if (in.status() != QDataStream::Ok) {
+            qWarning() << "PtyTranscript: Truncated transcript" << path;
+            break;
+        }
+        offsetUs += deltaUs;
+        transcript->chunks.append({static_cast<Direction>(direction), offsetUs, data});
+    }
+    return true;
+}
+
+bool PtyTranscriptWriter::open(const QString &path, int rows, int columns) {
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "PtyTranscript: Could not create" << path;
+        return false;
+    }
+
+    m_stream.setDevice(&m_file);
+    m_stream.setVersion(QDataStream::Qt_6_5);
+    m_stream << kMagic << kVersion << static_cast<quint16>(rows) << static_cast<quint16>(columns);
+
+    m_clock.start();
+    m_lastUs = 0;
+    return true;
+}
+
+void PtyTranscriptWriter::append(PtyTranscript::Direction direction, const QByteArray &data) {
+    if (!isOpen()) return;
+
+    const qint64 nowUs = m_clock.nsecsElapsed() / 1000;
+    const quint32 deltaUs = static_cast<quint32>(qMin<qint64>(nowUs - m_lastUs, 0xffffffff));
+    m_lastUs = nowUs;
+
+    m_stream << static_cast<quint8>(direction) << deltaUs << data;
+}
+
+void PtyTranscriptWriter::close() {
+    if (!isOpen()) return;
+    m_stream.setDevice(nullptr);
+    m_file.close();
+}
+
+bool PtyTranscriptWriter::isOpen() const {
+    return m_file.isOpen();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+// Compact binary recording of a PTY session: the terminal size, then every
+// output chunk and every write to the child with its time offset.
+// Used to replay provider sessions without the real CLI.
+struct PtyTranscript {
+    enum class Direction : quint8 {
+        Output = 0,
+        Input = 1
+    };
+
+    struct Chunk {
+        Direction direction;
+        qint64 offsetUs; // Since the session started
+        QByteArray data;
+    };
+
+    int rows = 40;
+    int columns = 120;
+    QList<Chunk> chunks;
+
+    static bool load(const QString &path, PtyTranscript *transcript);
+};
+
+class PtyTranscriptWriter {
+public:
+    bool open(const QString &path, int rows, int columns);
+    void append(PtyTranscript::Direction direction, const QByteArray &data);
+    void close();
+    bool isOpen() const;
+
+private:
+    QFile m_file;
+    QDataStream m_stream;
+    QElapsedTimer m_clock;
+    qint64 m_lastUs = 0;
+};
@@ -0,0 +1,237 @@
+#include "RefreshScheduler.h"
+#include <QDebug>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <utility>
+
+// Each refresh that finds nothing new stretches the interval by this much
+static constexpr double kBackoffFactor = 1.5;
+// Providers due this close together share one wakeup
+static constexpr qint64 kCoalesceMs = 1000;
+// Gap between two refreshes leaving the queue
+static constexpr int kStaggerMs = 500;
+// Refreshes that spawn a CLI (claude under a PTY, codex app-server) at once
+static constexpr int kMaxConcurrentSpawns = 1;
+// A refresh that never reports back stops holding its slot after this
+static constexpr int kRunTimeoutMs = 35000;
+// Due times move by up to this fraction of the interval either way
+static constexpr double kJitterFraction = 0.1;
+
+RefreshScheduler::RefreshScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &RefreshScheduler::onTimeout);
+    m_dispatchTimer.setSingleShot(true);
+    connect(&m_dispatchTimer, &QTimer::timeout, this, &RefreshScheduler::dispatchNext);
+}
+
+void RefreshScheduler::addProvider(Provider *provider) {
+    Entry entry;
+    entry.provider = provider;
+    entry.intervalMs = std::max(m_minimumMs, 0);
+    entry.nextDueMs = m_clock.elapsed() + entry.intervalMs;
+    m_entries.append(entry);
+
+    connect(provider, &Provider::dataChanged, this, [this, provider]() { onDataChanged(provider); });
+    connect(provider, &Provider::refreshRequested, this, [this, provider]() { requestRefresh(provider); });
+    // Nothing will follow; free the slot now rather than after kRunTimeoutMs
+    connect(provider, &Provider::refreshSkipped, this, [this, provider]() {
+        if (Entry *entry = this->entry(provider)) entry->awaitingData = false;
+        finishEntry(provider);
+    });
+    // Going Active is followed by data; Error and Stale are all we will get
+    connect(provider, &Provider::stateChanged, this, [this, provider](ProviderState state) {
+        if (state != ProviderState::Active) finishEntry(provider);
+    });
+    arm();
+}
+
+void RefreshScheduler::setIntervals(int minimumMs, int maximumMs) {
+    m_minimumMs = minimumMs;
+    m_maximumMs = std::max(minimumMs, maximumMs);
+    for (Entry &entry : m_entries) {
+        entry.intervalMs = std::clamp<qint64>(entry.intervalMs, m_minimumMs, m_maximumMs);
+        if (!entry.queued) scheduleNext(entry);
+    }
+    arm();
+}
+
+void RefreshScheduler::setPreferredProvider(ProviderID id) {
+    m_preferred = id;
+}
+
+void RefreshScheduler::refreshAll() {
+    for (Entry &entry : m_entries) {
+        entry.applyPhase = true;
+        enqueue(entry);
+    }
+    startDispatch(0);
+    arm();
+}
+
+RefreshScheduler::Entry *RefreshScheduler::entry(const Provider *provider) {
+    for (Entry &entry : m_entries) {
+        if (entry.provider == provider) return &entry;
+    }
+    return nullptr;
+}
+
+void RefreshScheduler::enqueue(Entry &entry) {
+    if (entry.queued) return;
+    entry.queued = true;
+    m_queue.append(entry.provider);
+}
+
+void RefreshScheduler::requestRefresh(Provider *provider) {
+    Entry *entry = this->entry(provider);
+    if (!entry) return;
+    enqueue(*entry);
+    startDispatch(0);
+    arm();
+}
+
+void RefreshScheduler::startDispatch(int delayMs) {
+    if (m_queue.isEmpty() || m_dispatchTimer.isActive()) return;
+    m_dispatchTimer.start(delayMs);
+}
+
+// Starts one queued refresh: the preferred provider if it is waiting,
+// otherwise the oldest one allowed to run. Spawning refreshes over the
+// cap, and providers whose previous refresh is still running, stay queued
+// until a running one finishes.
+void RefreshScheduler::dispatchNext() {
+    const bool spawnAllowed = runningSpawns() < kMaxConcurrentSpawns;
+    auto runnable = [this, spawnAllowed](const Provider *provider) {
+        if (entry(provider)->running) return false;
+        return spawnAllowed || !provider->spawnsProcess();
+    };
+
+    auto it = std::find_if(m_queue.begin(), m_queue.end(), [this, &runnable](const Provider *provider) {
+        return provider->id() == m_preferred && runnable(provider);
+    });
+    if (it == m_queue.end()) it = std::find_if(m_queue.begin(), m_queue.end(), runnable);
+    if (it == m_queue.end()) return;
+
+    Entry *next = entry(*it);
+    m_queue.erase(it);
+    next->queued = false;
+    refreshEntry(*next);
+
+    // Unconditionally: a refresh that finished inside refresh() has already
+    // asked for an immediate dispatch, and the next one must still wait
+    m_dispatchTimer.start(kStaggerMs);
+    arm();
+}
+
+void RefreshScheduler::refreshEntry(Entry &entry) {
+    entry.lastRefreshMs = m_clock.elapsed();
+    entry.awaitingData = true;
+    entry.running = true;
+    const int generation = ++entry.generation;
+    scheduleNext(entry);
+
+    // Safety net for a refresh that hangs without reporting back
+    Provider *provider = entry.provider;
+    QTimer::singleShot(kRunTimeoutMs, this, [this, provider, generation]() {
+        Entry *current = this->entry(provider);
+        if (current && current->generation == generation) finishEntry(provider);
+    });
+
+    provider->refresh();
+}
+
+void RefreshScheduler::finishEntry(Provider *provider) {
+    Entry *entry = this->entry(provider);
+    if (!entry || !entry->running) return;
+    entry->running = false;
+    // Deferred: this may run inside the provider's refresh(). Only shortens
+    // the wait when no stagger is pending.
+    startDispatch(0);
+    arm();
+}
+
+void RefreshScheduler::scheduleNext(Entry &entry) {
+    const qint64 spread = qRound64(entry.intervalMs * kJitterFraction);
+    qint64 due = entry.lastRefreshMs + entry.intervalMs + QRandomGenerator::global()->bounded(-spread, spread + 1);
+    if (std::exchange(entry.applyPhase, false)) {
+        due += qRound64(entry.intervalMs * phase(entry.provider->id()));
+    }
+    entry.nextDueMs = due;
+}
+
+void RefreshScheduler::onTimeout() {
+    const qint64 now = m_clock.elapsed();
+    for (Entry &entry : m_entries) {
+        if (!entry.running && entry.nextDueMs <= now + kCoalesceMs) enqueue(entry);
+    }
+    startDispatch(0);
+    arm();
+}
+
+void RefreshScheduler::arm() {
+    if (m_minimumMs <= 0) {
+        m_timer.stop();
+        return;
+    }
+
+    // Queued and running providers are rescheduled when they start
+    qint64 next = -1;
+    for (const Entry &entry : std::as_const(m_entries)) {
+        if (entry.queued || entry.running) continue;
+        if (next < 0 || entry.nextDueMs < next) next = entry.nextDueMs;
+    }
+    if (next < 0) {
+        m_timer.stop();
+        return;
+    }
+    m_timer.start(static_cast<int>(std::max<qint64>(0, next - m_clock.elapsed())));
+}
+
+int RefreshScheduler::runningSpawns() const {
+    return static_cast<int>(std::count_if(m_entries.cbegin(), m_entries.cend(), [](const Entry &entry) {
+        return entry.running && entry.provider->spawnsProcess();
+    }));
+}
+
+// Spreads the providers evenly over the interval, always in the same order
+double RefreshScheduler::phase(ProviderID id) {
+    return static_cast<double>(id) / static_cast<double>(ProviderID::Unknown);
+}
+
+void RefreshScheduler::onDataChanged(Provider *provider) {
+    Entry *entry = this->entry(provider);
+    if (!entry) return;
+
+    const QString current = fingerprint(provider->snapshot());
+    const bool changed = current != entry->fingerprint;
+    const bool answered = std::exchange(entry->awaitingData, false);
+    entry->fingerprint = current;
+    finishEntry(provider);
+    if (m_minimumMs <= 0) return;
+
+    // Pushed updates only ever tighten; a flat result counts once per refresh
+    const qint64 previous = entry->intervalMs;
+    if (changed) {
+        entry->intervalMs = m_minimumMs;
+    } else if (answered) {
+        entry->intervalMs = std::min<qint64>(m_maximumMs, qRound64(entry->intervalMs * kBackoffFactor));
+    }
+
+    if (entry->intervalMs != previous) {
+        qDebug() << "RefreshScheduler:" << provider->name() << "every" << entry->intervalMs / 1000 << "s"
+                 << (changed ? "(usage moving)" : "(usage flat)");
+        if (!entry->queued) scheduleNext(*entry);
+        arm();
+    }
+}
+
+// Reset countdowns tick every minute and are left out, only the numbers count
+QString RefreshScheduler::fingerprint(const UsageSnapshot &snapshot) {
+    QString result;
+    for (const UsageLimit &limit : snapshot.limits) {
+        result += QString("%1=%2/%3;").arg(limit.label).arg(limit.used, 0, 'f', 1).arg(limit.total, 0, 'f', 1);
+    }
+    return result;
+}
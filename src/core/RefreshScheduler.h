@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Provider.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+// Refreshes each provider on its own clock. A provider whose numbers moved
+// since its previous snapshot drops back to the minimum interval; every
+// refresh that comes back unchanged stretches its interval, up to the
+// maximum. A single timer is armed for whichever provider is due first.
+//
+// Due providers are not started all at once: they go through a queue that
+// starts them a moment apart and lets only a few process-spawning
+// refreshes run together, the preferred (selected) provider first. Each
+// provider also runs at a fixed phase within the interval plus a little
+// jitter, so their schedules don't line up again over time. Refreshes a
+// provider asks for itself go through the same queue.
+class RefreshScheduler : public QObject {
+    Q_OBJECT
+public:
+    explicit RefreshScheduler(QObject *parent = nullptr);
+
+    void addProvider(Provider *provider);
+
+    // Bounds in ms; a minimum <= 0 turns automatic refreshes off
+    void setIntervals(int minimumMs, int maximumMs);
+
+    // Jumps the queue whenever it is waiting
+    void setPreferredProvider(ProviderID id);
+
+    // Refreshes every provider now (startup, "Refresh All")
+    void refreshAll();
+
+private:
+    struct Entry {
+        Provider *provider = nullptr;
+        qint64 intervalMs = 0;
+        qint64 lastRefreshMs = 0; // On m_clock
+        qint64 nextDueMs = 0;
+        QString fingerprint;      // Of the last snapshot
+        bool awaitingData = false;
+        bool queued = false;
+        bool running = false;     // Until data, a state change or kRunTimeoutMs
+        bool applyPhase = false;  // Offset the next due time by the provider's phase
+        int generation = 0;
+    };
+
+    Entry *entry(const Provider *provider);
+    void enqueue(Entry &entry);
+    void requestRefresh(Provider *provider);
+    void dispatchNext();
+    void startDispatch(int delayMs);
+    void refreshEntry(Entry &entry);
+    void finishEntry(Provider *provider);
+    void scheduleNext(Entry &entry);
+    void onDataChanged(Provider *provider);
+    void onTimeout();
+    void arm();
+    int runningSpawns() const;
+    static double phase(ProviderID id);
+    static QString fingerprint(const UsageSnapshot &snapshot);
+
+    QList<Entry> m_entries;
+    QList<Provider *> m_queue;
+    ProviderID m_preferred = ProviderID::Unknown;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+    QTimer m_dispatchTimer;
+    int m_minimumMs = 60000;
+    int m_maximumMs = 900000;
+};
@@ -0,0 +1,528 @@
+#include "TerminalScreen.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+static constexpr char32_t kBlank = U' ';
+// Second cell of a double-width character, skipped when rendering text
+static constexpr char32_t kWideTail = 0;
+
+TerminalScreen::TerminalScreen(int rows, int columns)
+    : m_rows(rows)
+    , m_columns(columns)
+{
+    reset();
+}
+
+void TerminalScreen::resize(int rows, int columns) {
+    m_rows = std::max(rows, 1);
+    m_columns = std::max(columns, 1);
+    reset();
+}
+
+void TerminalScreen::reset() {
+    m_cells.assign(static_cast<size_t>(m_rows) * m_columns, kBlank);
+    m_dirty.assign(m_rows, false);
+    m_dirtyCount = 0;
+    m_cursorRow = 0;
+    m_cursorColumn = 0;
+    m_savedRow = 0;
+    m_savedColumn = 0;
+    m_pendingWrap = false;
+    m_scrollTop = 0;
+    m_scrollBottom = m_rows - 1;
+    m_state = State::Ground;
+    m_params.clear();
+    m_currentParam = -1;
+    m_privateMode = false;
+    m_decoder.resetState();
+}
+
+void TerminalScreen::feed(const QByteArray &data) {
+    const QString decoded = m_decoder.decode(data);
+    const qsizetype size = decoded.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        const QChar c = decoded.at(i);
+        char32_t ch = c.unicode();
+        if (c.isHighSurrogate() && i + 1 < size && decoded.at(i + 1).isLowSurrogate()) {
+            ch = QChar::surrogateToUcs4(c, decoded.at(i + 1));
+            ++i;
+        }
+        process(ch);
+    }
+}
+
+void TerminalScreen::process(char32_t ch) {
+    switch (m_state) {
+    case State::Ground:
+        if (ch == 0x1b) {
+            m_state = State::Escape;
+        } else if (ch < 0x20 || ch == 0x7f) {
+            executeControl(ch);
+        } else {
+            put(ch);
+        }
+        return;
+
+    case State::Escape:
+        executeEscape(ch);
+        return;
+
+    case State::EscapeIntermediate:
+        // Charset designations like ESC ( B — the final byte carries nothing we render
+        m_state = State::Ground;
+        return;
+
+    case State::Csi:
+        if (ch >= U'0' && ch <= U'9') {
+            m_currentParam = (m_currentParam < 0 ? 0 : m_currentParam * 10) + static_cast<int>(ch - U'0');
+            m_currentParam = std::min(m_currentParam, 99999);
+        } else if (ch == U';' || ch == U':') {
+            m_params.append(m_currentParam);
+            m_currentParam = -1;
+        } else if (ch == U'?' || ch == U'>' || ch == U'<' || ch == U'=') {
+            m_privateMode = true;
+        } else if (ch >= 0x40 && ch <= 0x7e) {
+            m_params.append(m_currentParam);
+            executeCsi(ch);
+            m_state = State::Ground;
+        } else if (ch == 0x1b) {
+            m_state = State::Escape;
+        } else if (ch < 0x20) {
+            // C0 controls are executed even in the middle of a sequence
+            executeControl(ch);
+        }
+        // Intermediate bytes (0x20-0x2f) are ignored
+        return;
+
+    case State::String:
+        if (ch == 0x07) m_state = State::Ground;
+        else if (ch == 0x1b) m_state = State::StringEscape;
+        return;
+
+    case State::StringEscape:
+        // ESC \ is the string terminator; anything else also ends the string
+        m_state = State::Ground;
+        return;
+    }
+}
+
+void TerminalScreen::executeControl(char32_t ch) {
+    switch (ch) {
+    case U'\r':
+        moveCursor(m_cursorRow, 0);
+        break;
+    case U'\n':
+    case 0x0b:
+    case 0x0c:
+        lineFeed();
+        break;
+    case U'\b':
+        moveCursor(m_cursorRow, m_cursorColumn - 1);
+        break;
+    case U'\t':
+        moveCursor(m_cursorRow, (m_cursorColumn / 8 + 1) * 8);
+        break;
+    default:
+        // BEL, shift in/out and the rest have no visible effect
+        break;
+    }
+}
+
+void TerminalScreen::executeEscape(char32_t ch) {
+    m_state = State::Ground;
+    switch (ch) {
+    case U'[':
+        m_state = State::Csi;
+        m_params.clear();
+        m_currentParam = -1;
+        m_privateMode = false;
+        break;
+    case U']':
+    case U'P':
+    case U'X':
+    case U'^':
+    case U'_':
+        m_state = State::String;
+        break;
+    case U'(':
+    case U')':
+    case U'*':
+    case U'+':
+    case U'#':
+    case U'%':
+    case U' ':
+        m_state = State::EscapeIntermediate;
+        break;
+    case U'7':
+        m_savedRow = m_cursorRow;
+        m_savedColumn = m_cursorColumn;
+        break;
+    case U'8':
+        moveCursor(m_savedRow, m_savedColumn);
+        break;
+    case U'D':
+        lineFeed();
+        break;
+    case U'E':
+        moveCursor(m_cursorRow, 0);
+        lineFeed();
+        break;
+    case U'M':
+        reverseIndex();
+        break;
+    case U'c':
+        reset();
+        eraseRows(0, m_rows - 1);
+        break;
+    default:
+        // Keypad modes (ESC = / ESC >) and unknown sequences
+        break;
+    }
+}
+
+int TerminalScreen::param(int index, int defaultValue) const {
+    if (index >= m_params.size() || m_params.at(index) <= 0) return defaultValue;
+    return m_params.at(index);
+}
+
+void TerminalScreen::executeCsi(char32_t final) {
+    if (m_privateMode) {
+        // Alternate screen buffer: we only model one screen, so start it blank
+        if (final == U'h' || final == U'l') {
+            for (int mode : std::as_const(m_params)) {
+                if (mode == 47 || mode == 1047 || mode == 1049) {
+                    eraseRows(0, m_rows - 1);
+                    if (final == U'h') moveCursor(0, 0);
+                }
+            }
+        }
+        return;
+    }
+
+    const int n = param(0, 1);
+    switch (final) {
+    case U'A':
+        moveCursor(m_cursorRow - n, m_cursorColumn);
+        break;
+    case U'B':
+    case U'e':
+        moveCursor(m_cursorRow + n, m_cursorColumn);
+        break;
+    case U'C':
+    case U'a':
+        moveCursor(m_cursorRow, m_cursorColumn + n);
+        break;
+    case U'D':
+        moveCursor(m_cursorRow, m_cursorColumn - n);
+        break;
+    case U'E':
+        moveCursor(m_cursorRow + n, 0);
+        break;
+    case U'F':
+        moveCursor(m_cursorRow - n, 0);
+        break;
+    case U'G':
+    case U'`':
+        moveCursor(m_cursorRow, n - 1);
+        break;
+    case U'd':
+        moveCursor(n - 1, m_cursorColumn);
+        break;
+    case U'H':
+    case U'f':
+        moveCursor(param(0, 1) - 1, param(1, 1) - 1);
+        break;
+    case U'J': {
+        const int mode = std::max(m_params.value(0), 0);
+        if (mode == 0) {
+            eraseCells(m_cursorRow, m_cursorColumn, m_columns - 1);
+            eraseRows(m_cursorRow + 1, m_rows - 1);
+        } else if (mode == 1) {
+            eraseRows(0, m_cursorRow - 1);
+            eraseCells(m_cursorRow, 0, m_cursorColumn);
+        } else {
+            eraseRows(0, m_rows - 1);
+        }
+        break;
+    }
+    case U'K': {
+        const int mode = std::max(m_params.value(0), 0);
+        if (mode == 0) eraseCells(m_cursorRow, m_cursorColumn, m_columns - 1);
+        else if (mode == 1) eraseCells(m_cursorRow, 0, m_cursorColumn);
+        else eraseCells(m_cursorRow, 0, m_columns - 1);
+        break;
+    }
+    case U'X':
+        eraseCells(m_cursorRow, m_cursorColumn, m_cursorColumn + n - 1);
+        break;
+    case U'P': {
+        char32_t *row = rowData(m_cursorRow);
+        const int count = std::min(n, m_columns - m_cursorColumn);
+        std::copy(row + m_cursorColumn + count, row + m_columns, row + m_cursorColumn);
+        std::fill(row + m_columns - count, row + m_columns, kBlank);
+        markDirty(m_cursorRow);
+        break;
+    }
+    case U'@': {
+        char32_t *row = rowData(m_cursorRow);
+        const int count = std::min(n, m_columns - m_cursorColumn);
+        std::copy_backward(row + m_cursorColumn, row + m_columns - count, row + m_columns);
+        std::fill(row + m_cursorColumn, row + m_cursorColumn + count, kBlank);
+        markDirty(m_cursorRow);
+        break;
+    }
+    case U'L':
+        if (m_cursorRow >= m_scrollTop && m_cursorRow <= m_scrollBottom)
+            scrollDown(m_cursorRow, m_scrollBottom, n);
+        break;
+    case U'M':
+        if (m_cursorRow >= m_scrollTop && m_cursorRow <= m_scrollBottom)
+            scrollUp(m_cursorRow, m_scrollBottom, n);
+        break;
+    case U'S':
+        scrollUp(m_scrollTop, m_scrollBottom, n);
+        break;
+    case U'T':
+        scrollDown(m_scrollTop, m_scrollBottom, n);
+        break;
+    case U'r': {
+        const int top = param(0, 1) - 1;
+        const int bottom = param(1, m_rows) - 1;
+        if (top < bottom && bottom < m_rows) {
+            m_scrollTop = top;
+            m_scrollBottom = bottom;
+        }
+        moveCursor(0, 0);
+        break;
+    }
+    case U's':
+        m_savedRow = m_cursorRow;
+        m_savedColumn = m_cursorColumn;
+        break;
+    case U'u':
+        moveCursor(m_savedRow, m_savedColumn);
+        break;
+    default:
+        // SGR (m), mode changes and reports don't affect the text
+        break;
+    }
+}
+
+void TerminalScreen::put(char32_t ch) {
+    // Zero-width characters (combining marks, joiners, variation selectors)
+    // attach to the previous cell rather than taking one of their own
+    const QChar::Category cat = QChar::category(ch);
+    if (cat == QChar::Mark_NonSpacing || cat == QChar::Mark_Enclosing || cat == QChar::Other_Format)
+        return;
+
+    const bool wide = m_columns > 1 && isWide(ch);
+    if (m_pendingWrap) {
+        m_cursorColumn = 0;
+        lineFeed();
+    }
+    // A wide character never straddles the margin: the last cell stays blank
+    if (wide && m_cursorColumn == m_columns - 1) {
+        clearCell(m_cursorRow, m_cursorColumn);
+        m_cursorColumn = 0;
+        lineFeed();
+    }
+
+    clearCell(m_cursorRow, m_cursorColumn);
+    rowData(m_cursorRow)[m_cursorColumn] = ch;
+    if (wide) {
+        clearCell(m_cursorRow, m_cursorColumn + 1);
+        rowData(m_cursorRow)[m_cursorColumn + 1] = kWideTail;
+    }
+    markDirty(m_cursorRow);
+
+    // The cursor stays on the last column until the next printable character
+    const int width = wide ? 2 : 1;
+    if (m_cursorColumn + width >= m_columns) {
+        m_cursorColumn = m_columns - 1;
+        m_pendingWrap = true;
+    } else {
+        m_cursorColumn += width;
+    }
+}
+
+void TerminalScreen::clearCell(int row, int column) {
+    // Overwriting either half of a wide character blanks the other half too
+    char32_t *data = rowData(row);
+    if (data[column] == kWideTail && column > 0) {
+        data[column - 1] = kBlank;
+    } else if (column + 1 < m_columns && data[column + 1] == kWideTail) {
+        data[column + 1] = kBlank;
+    }
+    data[column] = kBlank;
+}
+
+bool TerminalScreen::isWide(char32_t ch) {
+    // East Asian Wide/Fullwidth and default emoji presentation (Unicode 15),
+    // the characters a terminal draws across two cells
+    struct Range {
+        char32_t first;
+        char32_t last;
+    };
+    static constexpr Range kWide[] = {
+        {0x1100, 0x115f}, {0x231a, 0x231b}, {0x2329, 0x232a}, {0x23e9, 0x23ec},
+        {0x23f0, 0x23f0}, {0x23f3, 0x23f3}, {0x25fd, 0x25fe}, {0x2614, 0x2615},
+        {0x2648, 0x2653}, {0x267f, 0x267f}, {0x2693, 0x2693}, {0x26a1, 0x26a1},
+        {0x26aa, 0x26ab}, {0x26bd, 0x26be}, {0x26c4, 0x26c5}, {0x26ce, 0x26ce},
+        {0x26d4, 0x26d4}, {0x26ea, 0x26ea}, {0x26f2, 0x26f3}, {0x26f5, 0x26f5},
+        {0x26fa, 0x26fa}, {0x26fd, 0x26fd}, {0x2705, 0x2705}, {0x270a, 0x270b},
+        {0x2728, 0x2728}, {0x274c, 0x274c}, {0x274e, 0x274e}, {0x2753, 0x2755},
+        {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27b0, 0x27b0}, {0x27bf, 0x27bf},
+        {0x2b1b, 0x2b1c}, {0x2b50, 0x2b50}, {0x2b55, 0x2b55}, {0x2e80, 0x303e},
+        {0x3041, 0x33ff}, {0x3400, 0x4dbf}, {0x4e00, 0x9fff}, {0xa000, 0xa4cf},
+        {0xa960, 0xa97f}, {0xac00, 0xd7a3}, {0xf900, 0xfaff}, {0xfe10, 0xfe19},
+        {0xfe30, 0xfe6f}, {0xff00, 0xff60}, {0xffe0, 0xffe6}, {0x16fe0, 0x16fe4},
+        {0x17000, 0x18cff}, {0x1b000, 0x1b2ff}, {0x1f004, 0x1f004}, {0x1f0cf, 0x1f0cf},
+        {0x1f18e, 0x1f18e}, {0x1f191, 0x1f19a}, {0x1f200, 0x1f202}, {0x1f210, 0x1f23b},
+        {0x1f240, 0x1f248}, {0x1f250, 0x1f251}, {0x1f260, 0x1f265}, {0x1f300, 0x1f320},
+        {0x1f32d, 0x1f335}, {0x1f337, 0x1f37c}, {0x1f37e, 0x1f393}, {0x1f3a0, 0x1f3ca},
+        {0x1f3cf, 0x1f3d3}, {0x1f3e0, 0x1f3f0}, {0x1f3f4, 0x1f3f4}, {0x1f3f8, 0x1f43e},
+        {0x1f440, 0x1f440}, {0x1f442, 0x1f4fc}, {0x1f4ff, 0x1f53d}, {0x1f54b, 0x1f54e},
+        {0x1f550, 0x1f567}, {0x1f57a, 0x1f57a}, {0x1f595, 0x1f596}, {0x1f5a4, 0x1f5a4},
+        {0x1f5fb, 0x1f64f}, {0x1f680, 0x1f6c5}, {0x1f6cc, 0x1f6cc}, {0x1f6d0, 0x1f6d2},
+        {0x1f6d5, 0x1f6d7}, {0x1f6dc, 0x1f6df}, {0x1f6eb, 0x1f6ec}, {0x1f6f4, 0x1f6fc},
+        {0x1f7e0, 0x1f7eb}, {0x1f7f0, 0x1f7f0}, {0x1f90c, 0x1f93a}, {0x1f93c, 0x1f945},
+        {0x1f947, 0x1f9ff}, {0x1fa70, 0x1faff}, {0x20000, 0x2fffd}, {0x30000, 0x3fffd},
+    };
+
+    if (ch < kWide[0].first) return false;
+    const auto it = std::upper_bound(std::begin(kWide), std::end(kWide), ch,
+                                     [](char32_t value, const Range &range) { return value < range.first; });
+    return it != std::begin(kWide) && ch <= std::prev(it)->last;
+}
+
+void TerminalScreen::lineFeed() {
+    m_pendingWrap = false;
+    if (m_cursorRow == m_scrollBottom) {
+        scrollUp(m_scrollTop, m_scrollBottom, 1);
+    } else if (m_cursorRow < m_rows - 1) {
+        ++m_cursorRow;
+    }
+}
+
+void TerminalScreen::reverseIndex() {
+    m_pendingWrap = false;
+    if (m_cursorRow == m_scrollTop) {
+        scrollDown(m_scrollTop, m_scrollBottom, 1);
+    } else if (m_cursorRow > 0) {
+        --m_cursorRow;
+    }
+}
+
+void TerminalScreen::scrollUp(int top, int bottom, int count) {
+    if (count <= 0) return;
+    if (count > bottom - top) {
+        eraseRows(top, bottom);
+        return;
+    }
+    std::copy(rowData(top + count), rowData(bottom) + m_columns, rowData(top));
+    eraseRows(bottom - count + 1, bottom);
+    for (int row = top; row <= bottom; ++row) markDirty(row);
+}
+
+void TerminalScreen::scrollDown(int top, int bottom, int count) {
+    if (count <= 0) return;
+    if (count > bottom - top) {
+        eraseRows(top, bottom);
+        return;
+    }
+    std::copy_backward(rowData(top), rowData(bottom - count) + m_columns, rowData(bottom) + m_columns);
+    eraseRows(top, top + count - 1);
+    for (int row = top; row <= bottom; ++row) markDirty(row);
+}
+
+void TerminalScreen::eraseCells(int row, int from, int to) {
+    if (row < 0 || row >= m_rows) return;
+    from = std::max(from, 0);
+    to = std::min(to, m_columns - 1);
+    if (from > to) return;
+    char32_t *data = rowData(row);
+    std::fill(data + from, data + to + 1, kBlank);
+    markDirty(row);
+}
+
+void TerminalScreen::eraseRows(int from, int to) {
+    for (int row = std::max(from, 0); row <= std::min(to, m_rows - 1); ++row)
+        eraseCells(row, 0, m_columns - 1);
+}
+
+void TerminalScreen::moveCursor(int row, int column) {
+    m_pendingWrap = false;
+    m_cursorRow = std::clamp(row, 0, m_rows - 1);
+    m_cursorColumn = std::clamp(column, 0, m_columns - 1);
+}
+
+void TerminalScreen::markDirty(int row) {
+    if (!m_dirty[row]) {
+        m_dirty[row] = true;
+        ++m_dirtyCount;
+    }
+}
+
+QString TerminalScreen::rowText(int row) const {
+    if (row < 0 || row >= m_rows) return QString();
+    const char32_t *data = rowData(row);
+    int length = m_columns;
+    while (length > 0 && (data[length - 1] == kBlank || data[length - 1] == kWideTail)) --length;
+    if (std::find(data, data + length, kWideTail) == data + length)
+        return QString::fromUcs4(data, length);
+
+    QString text;
+    text.reserve(length);
+    int runStart = 0;
+    for (int column = 0; column <= length; ++column) {
+        if (column < length && data[column] != kWideTail) continue;
+        text.append(QString::fromUcs4(data + runStart, column - runStart));
+        runStart = column + 1;
+    }
+    return text;
+}
+
+QString TerminalScreen::text() const {
+    QString result;
+    result.reserve(m_rows * (m_columns + 1));
+    for (int row = 0; row < m_rows; ++row) {
+        if (row > 0) result.append(u'\n');
+        result.append(rowText(row));
+    }
+    return result;
+}
+
+bool TerminalScreen::contains(const QString &needle, Qt::CaseSensitivity cs) const {
+    for (int row = 0; row < m_rows; ++row) {
+        if (rowText(row).contains(needle, cs)) return true;
+    }
+    return false;
+}
+
+QList<int> TerminalScreen::dirtyRows() const {
+    QList<int> rows;
+    rows.reserve(m_dirtyCount);
+    for (int row = 0; row < m_rows; ++row) {
+        if (m_dirty[row]) rows.append(row);
+    }
+    return rows;
+}
+
+bool TerminalScreen::hasDirtyRows() const {
+    return m_dirtyCount > 0;
+}
+
+bool TerminalScreen::dirtyRowsContain(const QString &needle, Qt::CaseSensitivity cs) const {
+    if (m_dirtyCount == 0) return false;
+    for (int row = 0; row < m_rows; ++row) {
+        if (m_dirty[row] && rowText(row).contains(needle, cs)) return true;
+    }
+    return false;
+}
+
+void TerminalScreen::clearDirty() {
+    if (m_dirtyCount == 0) return;
+    std::fill(m_dirty.begin(), m_dirty.end(), false);
+    m_dirtyCount = 0;
+}
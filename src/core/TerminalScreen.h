@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringDecoder>
+#include <vector>
+
+// Minimal incremental VT100/xterm screen model. It implements the cursor
+// movement, erase and scroll controls TUIs use to draw, so callers see the
+// text a terminal would display instead of escape-stripped fragments.
+class TerminalScreen {
+public:
+    explicit TerminalScreen(int rows = 40, int columns = 120);
+
+    // Process a chunk of output; partial UTF-8 and escape sequences are
+    // carried over to the next call
+    void feed(const QByteArray &data);
+
+    // Clear the screen and parser state, optionally changing its size
+    void reset();
+    void resize(int rows, int columns);
+
+    int rows() const { return m_rows; }
+    int columns() const { return m_columns; }
+
+    QString rowText(int row) const; // Trailing blanks trimmed
+    QString text() const;           // All rows joined with '\n'
+    bool contains(const QString &needle, Qt::CaseSensitivity cs = Qt::CaseSensitive) const;
+
+    // Rows written since the last clearDirty(), in ascending order
+    QList<int> dirtyRows() const;
+    bool hasDirtyRows() const;
+    bool dirtyRowsContain(const QString &needle, Qt::CaseSensitivity cs = Qt::CaseSensitive) const;
+    void clearDirty();
+
+private:
+    enum class State {
+        Ground,
+        Escape,
+        EscapeIntermediate,
+        Csi,
+        String,      // OSC/DCS/APC payload, skipped until BEL or ST
+        StringEscape
+    };
+
+    void process(char32_t ch);
+    void executeControl(char32_t ch);
+    void executeEscape(char32_t ch);
+    void executeCsi(char32_t final);
+    void put(char32_t ch);
+    void clearCell(int row, int column);
+    static bool isWide(char32_t ch);
+    void lineFeed();
+    void reverseIndex();
+    void scrollUp(int top, int bottom, int count);
+    void scrollDown(int top, int bottom, int count);
+    void eraseCells(int row, int from, int to);
+    void eraseRows(int from, int to);
+    void moveCursor(int row, int column);
+    void markDirty(int row);
+    int param(int index, int defaultValue) const;
+
+    char32_t *rowData(int row) { return m_cells.data() + static_cast<size_t>(row) * m_columns; }
+    const char32_t *rowData(int row) const { return m_cells.data() + static_cast<size_t>(row) * m_columns; }
+
+    int m_rows;
+    int m_columns;
+    std::vector<char32_t> m_cells;
+    std::vector<bool> m_dirty;
+    int m_dirtyCount = 0;
+
+    int m_cursorRow = 0;
+    int m_cursorColumn = 0;
+    int m_savedRow = 0;
+    int m_savedColumn = 0;
+    bool m_pendingWrap = false;
+    int m_scrollTop = 0;
+    int m_scrollBottom = 0;
+
+    State m_state = State::Ground;
+    QList<int> m_params;
+    int m_currentParam = -1;
+    bool m_privateMode = false;
+    QStringDecoder m_decoder{QStringDecoder::Utf8};
+};
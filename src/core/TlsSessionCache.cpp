@@ -0,0 +1,95 @@
+#include "TlsSessionCache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+static constexpr quint32 kMagic = 0x43585453; // "CXTS"
+static constexpr quint16 kVersion = 1;
+// Servers that give no lifetime hint usually keep tickets for hours
+static constexpr int kDefaultLifetimeSecs = 2 * 3600;
+static constexpr int kMaxLifetimeSecs = 24 * 3600;
+
+TlsSessionCache::TlsSessionCache(const QString &filePath)
+    : m_filePath(filePath)
+{
+}
+
+QByteArray TlsSessionCache::ticket(const QString &hostPort) const {
+    auto it = m_entries.constFind(hostPort);
+    if (it == m_entries.cend()) return QByteArray();
+    if (it->expiresAtMs <= QDateTime::currentMSecsSinceEpoch()) return QByteArray();
+    return it->ticket;
+}
+
+bool TlsSessionCache::store(const QString &hostPort, const QByteArray &ticket, int lifetimeHintSecs) {
+    if (ticket.isEmpty()) return false;
+
+    auto it = m_entries.find(hostPort);
+    if (it != m_entries.end() && it->ticket == ticket) return false;
+
+    const int lifetime = lifetimeHintSecs > 0 ? qMin(lifetimeHintSecs, kMaxLifetimeSecs) : kDefaultLifetimeSecs;
+    m_entries.insert(hostPort, {ticket, QDateTime::currentMSecsSinceEpoch() + qint64(lifetime) * 1000});
+    return true;
+}
+
+bool TlsSessionCache::load() {
+    if (m_filePath.isEmpty()) return false;
+
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != kMagic || version != kVersion) {
+        qDebug() << "TlsSessionCache: ignoring incompatible cache file" << m_filePath;
+        return false;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString hostPort;
+        Entry entry;
+        in >> hostPort >> entry.ticket >> entry.expiresAtMs;
+        if (in.status() == QDataStream::Ok && entry.expiresAtMs > now) {
+            m_entries.insert(hostPort, entry);
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+bool TlsSessionCache::save() const {
+    if (m_filePath.isEmpty()) return false;
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+
+    // Tickets allow resuming sessions, keep them private to the user
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    quint32 count = 0;
+    for (const Entry &entry : m_entries) {
+        if (entry.expiresAtMs > now) ++count;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << kMagic << kVersion << count;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        if (it->expiresAtMs <= now) continue;
+        out << it.key() << it->ticket << it->expiresAtMs;
+    }
+    return file.commit();
+}
+
+void TlsSessionCache::removeFile() const {
+    if (!m_filePath.isEmpty()) QFile::remove(m_filePath);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+// TLS session tickets by "host:port", so new connections resume the
+// previous session instead of running a full handshake. Tickets live in
+// memory and can be written to a file to survive restarts.
+class TlsSessionCache {
+public:
+    explicit TlsSessionCache(const QString &filePath = QString());
+
+    // Empty when nothing usable is cached
+    QByteArray ticket(const QString &hostPort) const;
+    // Returns false when the ticket was already cached
+    bool store(const QString &hostPort, const QByteArray &ticket, int lifetimeHintSecs);
+
+    bool load();
+    bool save() const;
+    void removeFile() const;
+
+private:
+    struct Entry {
+        QByteArray ticket;
+        qint64 expiresAtMs = 0; // Epoch ms
+    };
+
+    QString m_filePath;
+    QHash<QString, Entry> m_entries;
+};
@@ -0,0 +1,110 @@
+#include "ClaudeUsageParser.h"
+#include <QTest>
+
+// Rows as TerminalScreen::rowText returns them for the Usage tab of
+// /status at 60 columns: box borders, bar glyphs, then the text.
+class ClaudeUsageParserTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void completePanel();
+    void sectionWithoutResetAfterFooter();
+    void sectionWithoutResetBeforeFooter();
+    void sectionWithoutPercentage();
+    void missingSession();
+
+private:
+    static void feed(ClaudeUsageParser &parser, const QStringList &rows);
+    static QStringList panel(bool sonnetReset, bool footer);
+};
+
+void ClaudeUsageParserTest::feed(ClaudeUsageParser &parser, const QStringList &rows) {
+    for (int row = 0; row < rows.size(); ++row) {
+        parser.updateRow(row, rows.at(row));
+    }
+}
+
+QStringList ClaudeUsageParserTest::panel(bool sonnetReset, bool footer) {
+    QStringList rows = {
+        "╭──────────────────────────────────────────────────────────╮",
+        "│ Status   Config   Usage                                  │",
+        "│                                                          │",
+        "│ Current session                                          │",
+        "│ ███▌                                      7% used        │",
+        "│ Resets 5pm (Europe/Bucharest)                            │",
+        "│                                                          │",
+        "│ Current week (all models)                                │",
+        "│ ██████                                   12% used        │",
+        "│ Resets Apr 10, 9:59am (Europe/Bucharest)                 │",
+        "│                                                          │",
+        "│ Current week (Sonnet only)                               │",
+        "│                                           0% used        │",
+        sonnetReset ? "│ Resets Apr 10, 9:59am (Europe/Bucharest)                 │"
+                    : "│                                                          │",
+        "│                                                          │",
+    };
+    rows.append(footer ? "│ Esc to cancel                                            │"
+                       : "│                                                          │");
+    rows.append("╰──────────────────────────────────────────────────────────╯");
+    return rows;
+}
+
+void ClaudeUsageParserTest::completePanel() {
+    ClaudeUsageParser parser;
+    feed(parser, panel(true, true));
+
+    QVERIFY(parser.hasLimits());
+    QVERIFY(parser.isComplete());
+    const QList<UsageLimit> limits = parser.limits();
+    QCOMPARE(limits.size(), 3);
+    QCOMPARE(limits.at(0).label, QString("Session"));
+    QCOMPARE(limits.at(0).used, 7.0);
+    QCOMPARE(limits.at(1).label, QString("Weekly (all)"));
+    QCOMPARE(limits.at(1).used, 12.0);
+}
+
+void ClaudeUsageParserTest::sectionWithoutResetAfterFooter() {
+    // Nothing used this week on Sonnet: claude draws no "Resets" line
+    ClaudeUsageParser parser;
+    feed(parser, panel(false, true));
+
+    QVERIFY(parser.isComplete());
+    const QList<UsageLimit> limits = parser.limits();
+    QCOMPARE(limits.size(), 3);
+    QCOMPARE(limits.at(2).label, QString("Weekly (Sonnet)"));
+    QCOMPARE(limits.at(2).used, 0.0);
+    QVERIFY(limits.at(2).resetDescription.isEmpty());
+}
+
+void ClaudeUsageParserTest::sectionWithoutResetBeforeFooter() {
+    // Same screen mid-redraw: the reset line may still be coming
+    ClaudeUsageParser parser;
+    feed(parser, panel(false, false));
+    QVERIFY(parser.hasLimits());
+    QVERIFY(!parser.isComplete());
+
+    // The footer arrives with the next frame
+    parser.updateRow(15, u"│ Esc to cancel                                            │");
+    QVERIFY(parser.isComplete());
+}
+
+void ClaudeUsageParserTest::sectionWithoutPercentage() {
+    // A header without its bar is half drawn, footer or not
+    ClaudeUsageParser parser;
+    feed(parser, panel(true, true));
+    parser.updateRow(12, u"│                                                          │");
+
+    QVERIFY(!parser.isComplete());
+}
+
+void ClaudeUsageParserTest::missingSession() {
+    ClaudeUsageParser parser;
+    QStringList rows = panel(true, true);
+    rows[4] = "│                                                          │";
+    feed(parser, rows);
+
+    QVERIFY(!parser.isComplete());
+}
+
+QTEST_GUILESS_MAIN(ClaudeUsageParserTest)
+#include "ClaudeUsageParserTest.moc"
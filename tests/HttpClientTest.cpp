@@ -0,0 +1,250 @@
+#include "HttpClient.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QTimer>
+#include <functional>
+#include <memory>
+
+// Minimal HTTP/1.1 server on localhost. Every request is answered according
+// to the handler, which sees the 1-based number of the request; responses
+// close the connection so each attempt arrives on its own socket.
+class StubServer {
+public:
+    struct Action {
+        enum Kind {
+            Respond,
+            Truncate, // Send the headers and part of the body, then close
+            Hang      // Never answer
+        };
+        Kind kind = Respond;
+        int status = 200;
+        QByteArray body;
+        int delayMs = 0;
+    };
+    using Handler = std::function<Action(int hit)>;
+
+    explicit StubServer(Handler handler)
+        : m_handler(std::move(handler))
+    {
+        QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this]() {
+            while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+                QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() { onReadyRead(socket); });
+            }
+        });
+        m_server.listen(QHostAddress::LocalHost);
+    }
+
+    bool isListening() const { return m_server.isListening(); }
+    int hits() const { return m_hits; }
+
+    QUrl url(const QString &path) const {
+        return QUrl(QString("http://127.0.0.1:%1%2").arg(m_server.serverPort()).arg(path));
+    }
+
+private:
+    void onReadyRead(QTcpSocket *socket) {
+        QByteArray &buffer = m_buffers[socket];
+        buffer.append(socket->readAll());
+
+        const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) return;
+        qsizetype contentLength = 0;
+        for (const QByteArray &line : buffer.left(headerEnd).split('\n')) {
+            if (line.toLower().startsWith("content-length:"))
+                contentLength = line.mid(15).trimmed().toLongLong();
+        }
+        if (buffer.size() < headerEnd + 4 + contentLength) return;
+        m_buffers.remove(socket);
+
+        const Action action = m_handler(++m_hits);
+        switch (action.kind) {
+        case Action::Truncate:
+            socket->write("HTTP/1.1 200 Stub\r\n"
+                          "Content-Type: text/plain\r\n"
+                          "Content-Length: 1000\r\n\r\npartial");
+            socket->disconnectFromHost();
+            break;
+        case Action::Hang:
+            break;
+        case Action::Respond: {
+            QPointer<QTcpSocket> target(socket);
+            QTimer::singleShot(action.delayMs, socket, [target, action]() {
+                if (!target || target->state() != QAbstractSocket::ConnectedState) return;
+                target->write("HTTP/1.1 " + QByteArray::number(action.status) + " Stub\r\n"
+                              "Content-Type: text/plain\r\n"
+                              "Content-Length: " + QByteArray::number(action.body.size()) + "\r\n"
+                              "Connection: close\r\n\r\n" + action.body);
+                target->disconnectFromHost();
+            });
+            break;
+        }
+        }
+    }
+
+    QTcpServer m_server;
+    Handler m_handler;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+    int m_hits = 0;
+};
+
+class HttpClientTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void deadlineExpiry();
+    void retryOnServerError();
+    void retryOnConnectionReset();
+    void noRetryWhenNotIdempotent();
+    void hedgedSecondRequest();
+
+private:
+    HttpResponse get(const QUrl &url, const HttpOptions &options);
+    HttpResponse post(const QUrl &url, const HttpOptions &options);
+    HttpResponse wait(const std::shared_ptr<HttpResponse> &result, const std::shared_ptr<bool> &done);
+};
+
+void HttpClientTest::initTestCase() {
+    // Keep the TLS cache setting and files away from the real profile
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+HttpResponse HttpClientTest::get(const QUrl &url, const HttpOptions &options) {
+    auto result = std::make_shared<HttpResponse>();
+    auto done = std::make_shared<bool>(false);
+    HttpClient::instance()->get(QNetworkRequest(url), this, [result, done](const HttpResponse &response) {
+        *result = response;
+        *done = true;
+    }, options);
+    return wait(result, done);
+}
+
+HttpResponse HttpClientTest::post(const QUrl &url, const HttpOptions &options) {
+    auto result = std::make_shared<HttpResponse>();
+    auto done = std::make_shared<bool>(false);
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    HttpClient::instance()->post(request, "{}", this, [result, done](const HttpResponse &response) {
+        *result = response;
+        *done = true;
+    }, options);
+    return wait(result, done);
+}
+
+HttpResponse HttpClientTest::wait(const std::shared_ptr<HttpResponse> &result, const std::shared_ptr<bool> &done) {
+    if (!QTest::qWaitFor([done]() { return *done; }, 10000)) {
+        HttpResponse timedOut;
+        timedOut.errorString = "test: callback never ran";
+        return timedOut;
+    }
+    return *result;
+}
+
+void HttpClientTest::deadlineExpiry() {
+    StubServer server([](int) { return StubServer::Action{StubServer::Action::Hang}; });
+    QVERIFY(server.isListening());
+
+    HttpOptions options;
+    options.timeoutMs = 200;
+    QElapsedTimer clock;
+    clock.start();
+    const HttpResponse response = get(server.url("/deadline"), options);
+
+    QVERIFY(response.timedOut);
+    QVERIFY(!response.ok());
+    QCOMPARE(response.error, QNetworkReply::OperationCanceledError);
+    QCOMPARE(response.attempts, 1);
+    QCOMPARE(server.hits(), 1);
+    QVERIFY(clock.elapsed() >= 150);
+    QVERIFY(clock.elapsed() < 5000);
+}
+
+void HttpClientTest::retryOnServerError() {
+    StubServer server([](int hit) {
+        if (hit == 1) return StubServer::Action{StubServer::Action::Respond, 503, "busy"};
+        return StubServer::Action{StubServer::Action::Respond, 200, "ok"};
+    });
+    QVERIFY(server.isListening());
+
+    HttpOptions options;
+    options.idempotent = true;
+    const HttpResponse response = get(server.url("/retry-5xx"), options);
+
+    QVERIFY(response.ok());
+    QCOMPARE(response.status, 200);
+    QCOMPARE(response.body, QByteArray("ok"));
+    QCOMPARE(response.attempts, 2);
+    QCOMPARE(server.hits(), 2);
+}
+
+void HttpClientTest::retryOnConnectionReset() {
+    // The connection drops in the middle of the first reply. Had it closed
+    // before any byte arrived, QNetworkAccessManager would resend on its own
+    // a version-dependent number of times; once the reply has started it
+    // reports RemoteHostClosedError instead, so every attempt is one hit.
+    StubServer server([](int hit) {
+        if (hit == 1) return StubServer::Action{StubServer::Action::Truncate};
+        return StubServer::Action{StubServer::Action::Respond, 200, "ok"};
+    });
+    QVERIFY(server.isListening());
+
+    HttpOptions options;
+    options.idempotent = true;
+    const HttpResponse response = get(server.url("/retry-reset"), options);
+
+    QVERIFY(response.ok());
+    QCOMPARE(response.body, QByteArray("ok"));
+    QCOMPARE(response.attempts, 2);
+    QCOMPARE(server.hits(), 2);
+}
+
+void HttpClientTest::noRetryWhenNotIdempotent() {
+    StubServer server([](int) { return StubServer::Action{StubServer::Action::Respond, 503, "busy"}; });
+    QVERIFY(server.isListening());
+
+    HttpOptions options;
+    options.idempotent = false;
+    options.hedge = true; // Ignored as well without idempotence
+    const HttpResponse response = post(server.url("/no-retry"), options);
+
+    QVERIFY(!response.ok());
+    QCOMPARE(response.status, 503);
+    QCOMPARE(response.attempts, 1);
+    QCOMPARE(server.hits(), 1);
+}
+
+void HttpClientTest::hedgedSecondRequest() {
+    // Ten quick answers build the latency history; the eleventh request
+    // stalls for 3 s, so only the hedged copy sent after ~p95 can answer
+    // "fast". The body proves it, without a wall-clock bound.
+    StubServer server([](int hit) {
+        if (hit <= 10) return StubServer::Action{StubServer::Action::Respond, 200, "warmup"};
+        if (hit == 11) return StubServer::Action{StubServer::Action::Respond, 200, "slow", 3000};
+        return StubServer::Action{StubServer::Action::Respond, 200, "fast"};
+    });
+    QVERIFY(server.isListening());
+
+    HttpOptions options;
+    options.idempotent = true;
+    options.hedge = true;
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(get(server.url("/hedge"), options).ok());
+    }
+    QCOMPARE(server.hits(), 10);
+
+    const HttpResponse response = get(server.url("/hedge"), options);
+
+    QVERIFY(response.ok());
+    QCOMPARE(response.body, QByteArray("fast"));
+    QCOMPARE(response.attempts, 1);
+    QCOMPARE(server.hits(), 12);
+}
+
+QTEST_GUILESS_MAIN(HttpClientTest)
+#include "HttpClientTest.moc"
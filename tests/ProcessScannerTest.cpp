@@ -0,0 +1,131 @@
+#include "ProcessScanner.h"
+#include <QTest>
+
+// Fixtures under data/proc follow the layout of a running language server,
+// written by hand: fd/ holds the socket links, net/ the matching tables.
+class ProcessScannerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void listeningPortsFromFixture();
+    void listeningPortsMissingProcess();
+    void listenRowsOnly();
+    void ipv6Rows();
+    void inodeMatching();
+    void headerAndMalformedLines();
+    void hexPorts_data();
+    void hexPorts();
+
+    void findByTruncatedComm();
+    void startTime();
+
+private:
+    static QByteArray row(const QByteArray &local, const QByteArray &state, const QByteArray &inode);
+
+    QString m_procRoot;
+    QByteArray m_header;
+};
+
+void ProcessScannerTest::initTestCase() {
+    m_procRoot = QFINDTESTDATA("data/proc");
+    QVERIFY(!m_procRoot.isEmpty());
+    m_header = "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n";
+}
+
+QByteArray ProcessScannerTest::row(const QByteArray &local, const QByteArray &state, const QByteArray &inode) {
+    return "   0: " + local + " 00000000:0000 " + state
+        + " 00000000:00000000 00:00000000 00000000  1000        0 " + inode
+        + " 1 0000000000000000 100 0 0 10 0\n";
+}
+
+void ProcessScannerTest::listeningPortsFromFixture() {
+    // 42069 listens on both families and is reported once; the established
+    // socket, the pipe and other processes' listeners are left out
+    QCOMPARE(ProcessScanner::listeningPorts(4242, m_procRoot), QList<int>({36687, 42069, 42070}));
+}
+
+void ProcessScannerTest::listeningPortsMissingProcess() {
+    QVERIFY(ProcessScanner::listeningPorts(4243, m_procRoot).isEmpty());
+}
+
+void ProcessScannerTest::listenRowsOnly() {
+    const QSet<quint64> inodes{100, 101, 102};
+    const QByteArray table = m_header
+        + row("0100007F:A455", "01", "100")  // ESTABLISHED
+        + row("0100007F:A456", "06", "101")  // TIME_WAIT
+        + row("0100007F:A457", "0A", "102"); // LISTEN
+    QCOMPARE(ProcessScanner::parseListeningPorts(table, inodes), QList<int>({42071}));
+}
+
+void ProcessScannerTest::ipv6Rows() {
+    const QSet<quint64> inodes{200, 201};
+    const QByteArray table = m_header
+        + row("00000000000000000000000001000000:A455", "0A", "200")
+        + row("0000000000000000FFFF00000100007F:1F90", "0A", "201");
+    QCOMPARE(ProcessScanner::parseListeningPorts(table, inodes), QList<int>({42069, 8080}));
+}
+
+void ProcessScannerTest::inodeMatching() {
+    const QByteArray table = m_header
+        + row("0100007F:A455", "0A", "300")
+        + row("0100007F:A456", "0A", "3000")
+        + row("0100007F:A457", "0A", "30");
+    QCOMPARE(ProcessScanner::parseListeningPorts(table, {300}), QList<int>({42069}));
+    QVERIFY(ProcessScanner::parseListeningPorts(table, {}).isEmpty());
+}
+
+void ProcessScannerTest::headerAndMalformedLines() {
+    const QSet<quint64> inodes{400, 401, 402, 403};
+    const QByteArray table = m_header
+        + "   0: 0100007F:A455 00000000:0000 0A\n"           // Truncated row
+        + row("0100007FA455", "0A", "400")                   // No port separator
+        + row("0100007F:ZZZZ", "0A", "401")                  // Port not hex
+        + row("0100007F:0000", "0A", "402")                  // Port 0
+        + "\n"
+        + "garbage\n"
+        + row("0100007F:A455", "0A", "403");
+    QCOMPARE(ProcessScanner::parseListeningPorts(table, inodes), QList<int>({42069}));
+
+    // Header only, and no table at all
+    QVERIFY(ProcessScanner::parseListeningPorts(m_header, inodes).isEmpty());
+    QVERIFY(ProcessScanner::parseListeningPorts(QByteArray(), inodes).isEmpty());
+}
+
+void ProcessScannerTest::hexPorts_data() {
+    QTest::addColumn<QByteArray>("local");
+    QTest::addColumn<int>("port");
+
+    QTest::newRow("lowest") << QByteArray("0100007F:0001") << 1;
+    QTest::newRow("http-alt") << QByteArray("00000000:1F90") << 8080;
+    QTest::newRow("lowercase") << QByteArray("0100007F:8f4f") << 36687;
+    QTest::newRow("highest") << QByteArray("0100007F:FFFF") << 65535;
+}
+
+void ProcessScannerTest::hexPorts() {
+    QFETCH(QByteArray, local);
+    QFETCH(int, port);
+
+    const QByteArray table = m_header + row(local, "0A", "500");
+    QCOMPARE(ProcessScanner::parseListeningPorts(table, {500}), QList<int>({port}));
+}
+
+void ProcessScannerTest::findByTruncatedComm() {
+    const QList<ProcessScanner::Process> found = ProcessScanner::find("language_server_linux_x64", m_procRoot);
+    QCOMPARE(found.size(), 1);
+    QCOMPARE(found.first().pid, 4242);
+    QCOMPARE(found.first().arguments.size(), 3);
+    QCOMPARE(found.first().startTime, quint64(987654));
+
+    // Same comm prefix, different executable
+    QVERIFY(ProcessScanner::find("language_server_macos_arm", m_procRoot).isEmpty());
+}
+
+void ProcessScannerTest::startTime() {
+    QCOMPARE(ProcessScanner::startTime(4242, m_procRoot), quint64(987654));
+    QCOMPARE(ProcessScanner::startTime(4243, m_procRoot), quint64(0));
+}
+
+QTEST_GUILESS_MAIN(ProcessScannerTest)
+#include "ProcessScannerTest.moc"